@@ -0,0 +1,49 @@
+#include "OfflineRender.h"
+#include <chrono>
+#include <vector>
+#include "engine/AudioEngineRT.h"
+#include "io/WavWriter.h"
+namespace mydaw::app {
+RenderStats render_session(const io::Session& s, const std::string& wavPath, int workers){
+  RenderStats st;
+  const auto t0 = std::chrono::steady_clock::now();
+  AudioEngineRT eng(s.sr);
+  if (workers > 0) eng.enableParallel(workers);
+  if (!eng.prepare(s.block)){ st.error = "graph has a cycle"; return st; }
+  eng.setTempo(s.bpm);
+  for (const auto& pad : s.pads){
+    const std::string path = !pad.file.empty() && pad.file[0] == '/' ? std::string(pad.file) : s.dir + "/" + std::string(pad.file);
+    sample::SampleRef audio = sample::SamplePool::shared().load(path, sample::SampleEncoding::Float32, st.error);
+    if (!audio) return st;
+    const auto [bank, slot] = GenIdMapper::gen_to_pad(pad.gen);
+    eng.sampler().set_sample(bank, slot, std::make_shared<const pads::PadSample>(std::move(audio), pad.gated));
+    ++st.pads;
+  }
+  st.skippedPlugins = s.plugins.size();
+  arrange::PatternRegistry registry;
+  if (!s.registry(registry, st.error)) return st;
+  eng.setActivePatterns(arrange::BuildPatternInstances(s.playlist, registry, 0));
+  const midi::TimeBase tb{s.sr, {s.bpm, 4, 4}};
+  const uint64_t total = s.seconds > 0 ? (uint64_t)(s.seconds * s.sr) : (uint64_t)tb.tick_to_samples(s.end_tick());
+  io::WavWriter wav;
+  if (!wav.open(wavPath, (int)s.sr, 2)){ st.error = "cannot write " + wavPath; return st; }
+  // Batch blocks per write so file I/O stays off the per-block path.
+  constexpr int kBlocksPerWrite = 64;
+  std::vector<float> buf((size_t)s.block * 2 * kBlocksPerWrite);
+  for (uint64_t done = 0; done < total;){
+    uint32_t filled = 0;
+    for (int b = 0; b < kBlocksPerWrite && done < total; ++b){
+      const int n = (int)std::min<uint64_t>((uint64_t)s.block, total - done);
+      eng.process(nullptr, buf.data() + (size_t)filled * 2, n);
+      filled += (uint32_t)n; done += (uint64_t)n;
+    }
+    if (!wav.write(buf.data(), filled)){ st.error = "write failed: " + wavPath; return st; }
+  }
+  if (!wav.close()){ st.error = "write failed: " + wavPath; return st; }
+  st.ok = true;
+  st.frames = total;
+  st.audioSeconds = (double)total / s.sr;
+  st.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return st;
+}
+} // namespace
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "io/Session.h"
+namespace mydaw::app {
+struct RenderStats{
+  bool ok{false};
+  std::string error;
+  uint64_t frames{0};
+  size_t pads{0};            // pad samples loaded into the sampler
+  size_t skippedPlugins{0};  // track plugins the renderer cannot host yet
+  double audioSeconds{0}, wallSeconds{0};
+  double realtimeFactor() const { return wallSeconds > 0 ? audioSeconds / wallSeconds : 0.0; }
+};
+// Renders a session to a stereo float WAV as fast as the CPU allows: no device, no lookahead
+// thread and nothing that waits on wall-clock time. workers > 0 runs graph branches in parallel.
+// The instrument is the engine's pad sampler, loaded with the session's pads; track plugin
+// chains are not built yet and are only counted in skippedPlugins.
+RenderStats render_session(const io::Session& session, const std::string& wavPath, int workers);
+} // namespace
@@ -1,5 +1,79 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-int main(){
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "app/OfflineRender.h"
+namespace {
+int usage(){
+  std::cerr << "usage: MyDAW render [--jobs N] [--threads N] [-o out.wav] session.json [session.json ...]\n"
+               "  Renders each session to WAV faster than realtime (default output: <session>.wav).\n"
+               "  --jobs     sessions rendered at once (default: one per core)\n"
+               "  --threads  graph worker threads per session (default: spare cores when rendering one)\n";
+  return 2;
+}
+std::string wav_path_for(const std::string& session){
+  const size_t dot = session.find_last_of('.');
+  const size_t slash = session.find_last_of('/');
+  return (dot != std::string::npos && (slash == std::string::npos || dot > slash) ? session.substr(0, dot) : session) + ".wav";
+}
+int render(int argc, char** argv){
+  int jobs = 0, threads = -1;
+  std::string out;
+  std::vector<std::string> sessions;
+  for (int i = 2; i < argc; ++i){
+    const bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--jobs") && hasValue) jobs = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "--threads") && hasValue) threads = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "-o") && hasValue) out = argv[++i];
+    else if (argv[i][0] == '-') return usage();
+    else sessions.push_back(argv[i]);
+  }
+  if (sessions.empty() || (!out.empty() && sessions.size() > 1)) return usage();
+  const int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+  if (jobs <= 0) jobs = std::min<int>(cores, (int)sessions.size());
+  if (threads < 0) threads = jobs == 1 ? cores - 1 : 0;
+
+  std::atomic<size_t> next{0};
+  std::atomic<int> failures{0};
+  std::mutex printMu;
+  double audioSeconds = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  auto worker = [&]{
+    for (size_t k; (k = next.fetch_add(1)) < sessions.size();){
+      const std::string& path = sessions[k];
+      std::string err;
+      mydaw::app::RenderStats st;
+      const auto session = mydaw::io::load_session(path, err);
+      if (!session) st.error = err;
+      else st = mydaw::app::render_session(*session, out.empty() ? wav_path_for(path) : out, threads);
+      std::lock_guard<std::mutex> lk(printMu);
+      if (!st.ok){ ++failures; std::cerr << path << ": " << st.error << "\n"; continue; }
+      audioSeconds += st.audioSeconds;
+      std::printf("%s: %.2f s audio in %.3f s (%.1fx realtime), %zu pads\n", path.c_str(), st.audioSeconds, st.wallSeconds, st.realtimeFactor(), st.pads);
+      if (st.skippedPlugins) std::printf("%s: %zu track plugin(s) not rendered: plugin hosting is not built yet\n", path.c_str(), st.skippedPlugins);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int j = 1; j < jobs; ++j) pool.emplace_back(worker);
+  worker();
+  for (auto& t : pool) t.join();
+  if (sessions.size() > 1){
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("total: %zu sessions, %.2f s audio in %.3f s (%.1fx realtime)\n", sessions.size(), audioSeconds, wall, wall > 0 ? audioSeconds / wall : 0.0);
+  }
+  return failures ? 1 : 0;
+}
+} // namespace
+int main(int argc, char** argv){
+  if (argc > 1 && !std::strcmp(argv[1], "render")) return render(argc, argv);
+  if (argc > 1) return usage();
   std::cout<<"MyDAW scaffold\n";
   return 0;
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory_resource>
 #include <vector>
 struct Clip{ int id; long long start; long long len; int track; };
-struct Playlist{ std::vector<Clip> clips; };
+struct Playlist{ std::pmr::vector<Clip> clips; };
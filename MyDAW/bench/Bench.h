@@ -0,0 +1,59 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+namespace mydaw::bench {
+// One timed case. Times are per call of the benchmarked function.
+struct Result{ std::string name; double nsPerOp; double minNs; uint64_t iters; double itemsPerOp; };
+// Minimal harness: each case is run in kSamples batches whose size is calibrated so a batch
+// takes about minTime/kSamples; the median batch is reported (min alongside, as a noise hint).
+class Runner{
+  std::string filter_;
+  double minTime_;
+  std::vector<Result> results_;
+public:
+  static constexpr int kSamples = 9;
+  Runner(std::string filter, double minTimeSec): filter_(std::move(filter)), minTime_(minTimeSec) {}
+  bool wants(const std::string& name) const { return filter_.empty() || name.find(filter_) != std::string::npos; }
+  // itemsPerOp: frames or events processed per call, reported as throughput.
+  template<class F> void run(const std::string& name, double itemsPerOp, F&& fn){
+    if (!wants(name)) return;
+    using clock = std::chrono::steady_clock;
+    auto time_batch = [&](uint64_t n){
+      const auto t0 = clock::now();
+      for (uint64_t i = 0; i < n; ++i) fn();
+      return std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+    };
+    const double target = minTime_ * 1e9 / kSamples;
+    uint64_t iters = 1;
+    for (double t; (t = time_batch(iters)) < target && iters < (1ull << 40);)
+      iters = t <= 0 ? iters * 16 : std::max<uint64_t>(iters * 2, (uint64_t)((double)iters * target / t));
+    std::vector<double> per(kSamples);
+    for (auto& p : per) p = time_batch(iters) / (double)iters;
+    std::sort(per.begin(), per.end());
+    results_.push_back({name, per[kSamples / 2], per[0], iters, itemsPerOp});
+    const Result& r = results_.back();
+    std::printf("%-48s %12.1f ns/op %12.1f min %10.2f Mitems/s\n", r.name.c_str(), r.nsPerOp, r.minNs,
+                r.nsPerOp > 0 ? r.itemsPerOp * 1e3 / r.nsPerOp : 0.0);
+    std::fflush(stdout);
+  }
+  const std::vector<Result>& results() const { return results_; }
+  bool write_json(const std::string& path) const {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results_.size(); ++i){
+      const Result& r = results_[i];
+      std::fprintf(f, "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"min_ns\": %.3f, \"iterations\": %llu, \"items_per_op\": %.1f}%s\n",
+                   r.name.c_str(), r.nsPerOp, r.minNs, (unsigned long long)r.iters, r.itemsPerOp, i + 1 < results_.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    return std::fclose(f) == 0;
+  }
+};
+// Keeps the optimizer from discarding a computed value.
+template<class T> inline void keep(const T& v){ asm volatile("" : : "g"(&v) : "memory"); }
+} // namespace
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+"""Compare two MyDAW_bench --json runs and flag regressions.
+
+usage: compare.py baseline.json current.json [--threshold PERCENT]
+
+Exits 1 when any benchmark present in both runs got slower (median ns/op) by more
+than the threshold (default 5%), so it can gate CI or a local before/after check.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("baseline")
+    ap.add_argument("current")
+    ap.add_argument("--threshold", type=float, default=5.0, help="percent slowdown that counts as a regression")
+    args = ap.parse_args()
+
+    base, cur = load(args.baseline), load(args.current)
+    regressions = 0
+    print(f"{'benchmark':48} {'base ns':>12} {'new ns':>12} {'change':>8}")
+    for name in sorted(base.keys() & cur.keys()):
+        b, c = base[name]["ns_per_op"], cur[name]["ns_per_op"]
+        change = (c - b) / b * 100.0 if b > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  improved"
+        print(f"{name:48} {b:12.1f} {c:12.1f} {change:+7.1f}%{flag}")
+    for name in sorted(base.keys() - cur.keys()):
+        print(f"{name:48} missing from {args.current}")
+    for name in sorted(cur.keys() - base.keys()):
+        print(f"{name:48} new")
+    if regressions:
+        print(f"{regressions} regression(s) above {args.threshold:g}%")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
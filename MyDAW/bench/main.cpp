@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "dsp/CounterRng.h"
+#include "dsp/Resampler.h"
+#include "engine/AudioEngineRT.h"
+#include "midi/scheduler.hpp"
+#include "midi/timeline.hpp"
+#include "pads/PadSampler.h"
+#include "sample/SampleLoader.h"
+#include "plugins/analytica_vaccine/include/AnalyticaVaccine.h"
+#include "plugins/fractal_remixer/include/FractalRemixer.h"
+#include "plugins/momentum_delay/include/MomentumDelay.h"
+#include "plugins/nostalgia_tron/include/NostalgiaTron.h"
+#include "plugins/quantum_80/include/Quantum80.h"
+#include "plugins/rhythm_composer/include/RhythmComposer.h"
+#include "plugins/sonnet_composer/include/SonnetComposer.h"
+#include "plugins/velocity_eq/include/VelocityEQ.h"
+using namespace mydaw;
+namespace {
+constexpr double kSr = 48000.0;
+std::string fmt(const char* f, long a, long b = 0, long c = 0){
+  char buf[128]; std::snprintf(buf, sizeof buf, f, a, b, c); return buf;
+}
+// One bar with `notes` evenly spaced notes on four generators.
+midi::Pattern make_pattern(int notes, int seed){
+  midi::Pattern p;
+  p.length = midi::kPPQ * 4;
+  for (int g = 0; g < 4; ++g) p.channels.push_back({midi::GenId((1 << 8) | (uint32_t)(seed * 4 + g) % 256), {}});
+  const midi::Tick step = std::max<midi::Tick>(p.length / std::max(notes, 1), 1);
+  for (int n = 0; n < notes; ++n){
+    midi::Note note;
+    note.start = (midi::Tick)n * step % p.length; note.len = step / 2 + 1;
+    note.pitch = (uint8_t)(36 + (n * 7 + seed) % 48); note.vel = 100;
+    p.channels[(size_t)n % 4].notes.push_back(note);
+  }
+  return p;
+}
+std::vector<midi::PatternInstance> make_instances(const std::vector<midi::Pattern>& pats, int loops){
+  std::vector<midi::PatternInstance> v;
+  for (int l = 0; l < loops; ++l){
+    midi::PatternInstance inst;
+    inst.pattern = &pats[(size_t)l % pats.size()];
+    inst.startTick = (midi::Tick)(l % 8) * midi::kPPQ / 8; // staggered so runs interleave
+    inst.loopLengthTicks = inst.pattern->length;
+    v.push_back(inst);
+  }
+  midi::Scheduler::compile_timelines(v);
+  return v;
+}
+void bench_scheduler(bench::Runner& r){
+  const uint32_t frames = 256;
+  for (int notes : {16, 256, 4096}){
+    const midi::Pattern pat = make_pattern(notes, 0);
+    const auto tl = midi::PatternTimeline::compile(pat);
+    midi::Scheduler sched{midi::TimeBase{kSr, {120.0, 4, 4}}};
+    std::vector<midi::Ev> out; out.reserve(8192);
+    int64_t pos = 0;
+    r.run(fmt("scheduler/gather/notes=%ld", notes), frames, [&]{
+      out.clear();
+      sched.gather(*tl, 0, pat.length, pos, frames, out);
+      pos += frames;
+      bench::keep(out.data());
+    });
+  }
+  for (int loops : {1, 16, 128}){
+    for (int notes : {16, 256}){
+      std::vector<midi::Pattern> pats;
+      for (int i = 0; i < 8; ++i) pats.push_back(make_pattern(notes, i));
+      const auto instances = make_instances(pats, loops);
+      midi::Scheduler sched{midi::TimeBase{kSr, {120.0, 4, 4}}};
+      sched.reserve(AudioEngineRT::kMaxBlockEvents, AudioEngineRT::kMaxBlockRuns);
+      midi::EventLanes out; out.reserve(AudioEngineRT::kMaxBlockEvents);
+      int64_t pos = 0;
+      r.run(fmt("scheduler/gather_realtime/loops=%ld/notes=%ld", loops, notes), frames, [&]{
+        sched.gather_realtime(instances, pos, frames, out);
+        pos += frames;
+        bench::keep(out.size());
+      });
+    }
+  }
+}
+// 16-bit stereo WAV of noise, distinct per seed.
+bool write_noise_wav(const std::string& path, uint32_t frames, uint64_t seed){
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  if (!f) return false;
+  const uint32_t data = frames * 4;
+  auto u32 = [&](uint32_t v){ std::fwrite(&v, 4, 1, f); };
+  auto u16 = [&](uint16_t v){ std::fwrite(&v, 2, 1, f); };
+  std::fwrite("RIFF", 1, 4, f); u32(36 + data); std::fwrite("WAVEfmt ", 1, 8, f);
+  u32(16); u16(1); u16(2); u32((uint32_t)kSr); u32((uint32_t)kSr * 4); u16(4); u16(16);
+  std::fwrite("data", 1, 4, f); u32(data);
+  std::vector<int16_t> pcm((size_t)frames * 2);
+  for (size_t i = 0; i < pcm.size(); ++i) pcm[i] = (int16_t)(16000.0f * dsp::CounterRng::bipolar(dsp::CounterRng::hash(seed, i)));
+  const bool ok = std::fwrite(pcm.data(), 2, pcm.size(), f) == pcm.size();
+  return std::fclose(f) == 0 && ok;
+}
+// The samplers' kit, written once: 2 s keyzones rooted at C2..C5 in strings/ (NostalgiaTron's
+// default set) and one 2 s file per pad in pads/. Empty if it cannot be written.
+const std::string& plugin_kit(){
+  static const std::string dir = []{
+    const auto root = std::filesystem::temp_directory_path() / "mydaw_bench_plugins";
+    std::error_code ec;
+    std::filesystem::create_directories(root / "strings", ec);
+    std::filesystem::create_directories(root / "pads", ec);
+    for (int i = 0; i < 4; ++i){
+      const std::string zone = (root / "strings" / fmt("%ld.wav", 36 + 12 * i)).string();
+      const std::string pad = (root / "pads" / fmt("%ld.wav", i)).string();
+      if (!std::filesystem::exists(zone) && !write_noise_wav(zone, (uint32_t)(2 * kSr), (uint64_t)(100 + i))) return std::string();
+      if (!std::filesystem::exists(pad) && !write_noise_wav(pad, (uint32_t)(2 * kSr), (uint64_t)(200 + i))) return std::string();
+    }
+    return root.string();
+  }();
+  return dir;
+}
+struct PluginCase{
+  const char* name;
+  std::function<std::unique_ptr<Node>()> make;
+  std::function<bool(Node&)> load;   // after prepare(), before timing; null if there is nothing to load
+  std::function<void(Node&)> excite; // called every 64 blocks so instruments keep sounding
+};
+std::vector<PluginCase> plugin_cases(){
+  using namespace mydaw::plugins;
+  auto none = [](Node&){};
+  return {
+    {"AnalyticaVaccine", []{ return std::make_unique<analytica_vaccine::AnalyticaVaccine>(); }, nullptr, none},
+    {"FractalRemixer", []{ return std::make_unique<fractal_remixer::FractalRemixer>(); }, nullptr, none},
+    {"MomentumDelay", []{ return std::make_unique<momentum_delay::MomentumDelay>(); }, nullptr, none},
+    {"NostalgiaTron", []{ return std::make_unique<nostalgia_tron::NostalgiaTron>(); },
+      [](Node& n){
+        if (plugin_kit().empty()) return false;
+        auto& nt = static_cast<nostalgia_tron::NostalgiaTron&>(n);
+        nt.setSampleLibrary(plugin_kit());
+        bool ok = false;
+        nt.preloadSampleSet(sample::kNow, [&ok](bool loaded){ ok = loaded; });
+        sample::SampleLoader::shared().drain(); // zones resident, so noteOn never waits on a load
+        return ok;
+      },
+      [](Node& n){ for (int k = 0; k < 4; ++k) static_cast<nostalgia_tron::NostalgiaTron&>(n).noteOn(48 + k * 4, 0.8f); }},
+    {"Quantum80", []{ return std::make_unique<quantum_80::Quantum80>(); }, nullptr,
+      [](Node& n){ for (int k = 0; k < 4; ++k) static_cast<quantum_80::Quantum80&>(n).noteOn(48 + k * 4, 0.8f); }},
+    {"RhythmComposer", []{ return std::make_unique<rhythm_composer::RhythmComposer>(); },
+      [](Node& n){
+        if (plugin_kit().empty()) return false;
+        bool ok = true;
+        for (int k = 0; k < 4; ++k)
+          ok = static_cast<rhythm_composer::RhythmComposer&>(n).loadSample(k, plugin_kit() + fmt("/pads/%ld.wav", k)) && ok;
+        return ok;
+      },
+      [](Node& n){ for (int k = 0; k < 4; ++k) static_cast<rhythm_composer::RhythmComposer&>(n).triggerPad(k, 0.8f); }},
+    {"SonnetComposer", []{ return std::make_unique<sonnet_composer::SonnetComposer>(); }, nullptr, none},
+    {"VelocityEQ", []{ return std::make_unique<velocity_eq::VelocityEQ>(); }, nullptr, none},
+  };
+}
+void bench_plugins(bench::Runner& r){
+  constexpr int kMaxFrames = 2048;
+  struct alignas(AudioBlock::kAlign) Channel{ float s[kMaxFrames]; }; // as the graph hands them out
+  std::vector<Channel> buf(4);
+  for (int i = 0; i < kMaxFrames; ++i){
+    buf[0].s[i] = 0.25f * dsp::CounterRng::bipolar(dsp::CounterRng::hash(1, (uint64_t)i));
+    buf[1].s[i] = 0.25f * dsp::CounterRng::bipolar(dsp::CounterRng::hash(2, (uint64_t)i));
+  }
+  float* in[2] = {buf[0].s, buf[1].s};
+  float* out[2] = {buf[2].s, buf[3].s};
+  for (const auto& pc : plugin_cases()){
+    for (int frames = 32; frames <= kMaxFrames; frames *= 2){
+      const std::string name = std::string("plugin/") + pc.name + fmt("/frames=%ld", frames);
+      if (!r.wants(name)) continue;
+      auto node = pc.make();
+      node->prepare(kSr, kMaxFrames);
+      if (pc.load && !pc.load(*node)){ std::cerr << name << ": cannot load samples\n"; continue; }
+      const AudioBlock blk{in, out, frames, kSr, 2, AudioBlock::padded(frames), false};
+      uint32_t calls = 0;
+      r.run(name, frames, [&]{
+        if ((calls++ & 63) == 0) pc.excite(*node);
+        node->process(blk);
+        bench::keep(buf[2].s[0]);
+      });
+    }
+  }
+}
+// `voices` one-shots held sounding across 64 pads of 2 s stereo samples; a 44.1 kHz kit is
+// resampled to the 48 kHz engine rate, a 48 kHz one is mixed directly.
+void bench_pads(bench::Runner& r){
+  for (double kitRate : {48000.0, 44100.0}){
+    for (int voices : {32, 128, 256}){
+      for (dsp::Interp q : dsp::kInterps){
+        if (kitRate == kSr && q != pads::PadSampler::kDefaultInterp) continue; // mixed directly: interpolation unused
+        const int frames = 256;
+        const std::string name = fmt("pads/PadSampler/voices=%ld/frames=%ld/", voices, frames) + (kitRate == kSr ? "direct" : std::string("resampled/") + dsp::interp_name(q));
+        if (!r.wants(name)) continue;
+        pads::PadSampler ps;
+        ps.set_max_voices(voices);
+        ps.set_interpolation(q);
+        ps.prepare(kSr, frames);
+        std::vector<std::vector<float>> chans(2, std::vector<float>((size_t)(2 * kitRate)));
+        for (int p = 0; p < 64; ++p){
+          for (size_t i = 0; i < chans[0].size(); ++i)
+            for (int c = 0; c < 2; ++c) chans[(size_t)c][i] = 0.5f * dsp::CounterRng::bipolar(dsp::CounterRng::hash((uint64_t)p, i, (uint64_t)c));
+          ps.set_sample(1, (uint8_t)p, std::make_shared<pads::PadSample>(chans, kitRate));
+        }
+        std::vector<float> l((size_t)frames), rr((size_t)frames);
+        float* out[2] = {l.data(), rr.data()};
+        const AudioBlock blk{out, out, frames, kSr, 2, AudioBlock::padded(frames), false};
+        uint32_t hits = 0;
+        r.run(name, (double)frames * voices, [&]{
+          while (ps.active_voices() < voices) ps.note_on({1, (uint8_t)(hits++ % 64), 100});
+          ps.process(blk);
+          bench::keep(l[0]);
+        });
+      }
+    }
+  }
+}
+// The resampling kernel alone: one voice rendering a block from a 2 s source pitched down a
+// semitone, so ns/op is the cost of a voice per block at each interpolation tier.
+void bench_resample(bench::Runner& r){
+  const int frames = 256;
+  const size_t len = (size_t)(2 * kSr);
+  std::vector<float> f32(len);
+  std::vector<int16_t> i16(len);
+  for (size_t i = 0; i < len; ++i){
+    f32[i] = 0.5f * dsp::CounterRng::bipolar(dsp::CounterRng::hash(7, i));
+    i16[i] = (int16_t)(f32[i] * 32767.0f);
+  }
+  dsp::warm_resampler();
+  std::vector<float> out((size_t)frames);
+  const float rate = std::exp2(-1.0f / 12.0f);
+  for (dsp::Interp q : dsp::kInterps){
+    for (bool pcm16 : {false, true}){
+      const std::string name = std::string("resample/") + dsp::interp_name(q) + (pcm16 ? "/int16" : "/float") + fmt("/voice/frames=%ld", frames);
+      if (!r.wants(name)) continue;
+      double pos = 0.0;
+      r.run(name, frames, [&]{
+        if (pos > (double)len - 2.0 * frames) pos = 0.0;
+        std::fill(out.begin(), out.end(), 0.0f);
+        pos = pcm16 ? dsp::mix_resample(q, out.data(), i16.data(), (int64_t)len, pos, rate, 1.0f, 0.0f, frames)
+                    : dsp::mix_resample(q, out.data(), f32.data(), (int64_t)len, pos, rate, 1.0f, 0.0f, frames);
+        bench::keep(out[0]);
+      });
+    }
+  }
+}
+// Opening a kit: 64 one-second files decoded into the pool by a loader with 1..cores workers.
+// The files sit in the page cache after the first op, so this measures decoding, not the disk.
+void bench_loader(bench::Runner& r){
+  constexpr int kFiles = 64;
+  const int cores = (int)std::max(1u, std::thread::hardware_concurrency());
+  std::vector<int> counts;
+  for (int w = 1; w < cores; w *= 2) counts.push_back(w);
+  counts.push_back(cores);
+  std::vector<std::string> paths;
+  for (int workers : counts){
+    const std::string name = fmt("loader/kit/files=%ld/workers=%ld", kFiles, workers);
+    if (!r.wants(name)) continue;
+    if (paths.empty()){
+      const auto dir = std::filesystem::temp_directory_path() / "mydaw_bench_kit";
+      std::filesystem::create_directories(dir);
+      for (int i = 0; i < kFiles; ++i){
+        paths.push_back((dir / fmt("%ld.wav", i)).string());
+        if (!std::filesystem::exists(paths.back()) && !write_noise_wav(paths.back(), (uint32_t)kSr, (uint64_t)i)){ std::cerr << name << ": cannot write kit\n"; return; }
+      }
+    }
+    sample::SampleLoader loader(workers);
+    r.run(name, kFiles, [&]{
+      std::vector<std::shared_ptr<sample::LazySample>> kit;
+      for (int i = 0; i < kFiles; ++i){
+        kit.push_back(loader.make(paths[(size_t)i]));
+        loader.prefetch(kit.back(), (sample::Deadline)i);
+      }
+      loader.drain();
+      bench::keep(kit.back()->ready());
+      kit.clear();
+      sample::SamplePool::shared().collect();
+    });
+  }
+}
+// A synthetic session: `tracks` looping one-bar patterns, and per track an EQ -> delay chain
+// on the engine input, all summed into the output.
+void bench_engine(bench::Runner& r){
+  using namespace mydaw::plugins;
+  for (int tracks : {1, 8, 32}){
+    for (int frames : {64, 256, 1024}){
+      const std::string name = fmt("engine/block/tracks=%ld/frames=%ld", tracks, frames);
+      if (!r.wants(name)) continue;
+      std::vector<midi::Pattern> pats;
+      for (int i = 0; i < tracks; ++i) pats.push_back(make_pattern(64, i));
+      AudioEngineRT eng(kSr);
+      std::vector<std::unique_ptr<Node>> chain;
+      for (int t = 0; t < tracks; ++t){
+        chain.push_back(std::make_unique<velocity_eq::VelocityEQ>());
+        chain.push_back(std::make_unique<momentum_delay::MomentumDelay>());
+        const auto eq = eng.graph().add(chain[chain.size() - 2].get());
+        const auto delay = eng.graph().add(chain.back().get());
+        eng.graph().connect(eng.graph().input(), eq);
+        eng.graph().connect(eq, delay);
+        eng.graph().connect(delay, eng.graph().output());
+      }
+      if (!eng.prepare(frames)){ std::cerr << name << ": prepare failed\n"; continue; }
+      eng.setActivePatterns(make_instances(pats, tracks));
+      std::vector<float> in((size_t)frames * 2, 0.1f), out((size_t)frames * 2);
+      r.run(name, frames, [&]{
+        eng.process(in.data(), out.data(), frames);
+        bench::keep(out[0]);
+      });
+    }
+  }
+}
+int usage(){
+  std::cerr << "usage: MyDAW_bench [--filter SUBSTR] [--min-time SECONDS] [--json out.json]\n"
+               "  Compare two JSON runs with bench/compare.py.\n";
+  return 2;
+}
+} // namespace
+int main(int argc, char** argv){
+  std::string filter, json;
+  double minTime = 0.2;
+  for (int i = 1; i < argc; ++i){
+    const bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--filter") && hasValue) filter = argv[++i];
+    else if (!std::strcmp(argv[i], "--min-time") && hasValue) minTime = std::atof(argv[++i]);
+    else if (!std::strcmp(argv[i], "--json") && hasValue) json = argv[++i];
+    else return usage();
+  }
+  if (minTime <= 0) return usage();
+  bench::Runner r(filter, minTime);
+  bench_scheduler(r);
+  bench_plugins(r);
+  bench_pads(r);
+  bench_resample(r);
+  bench_loader(r);
+  bench_engine(r);
+  if (!json.empty() && !r.write_json(json)){ std::cerr << "cannot write " << json << "\n"; return 1; }
+  return 0;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdint>
+namespace mydaw::dsp {
+// Stateless counter-based RNG (SplitMix64 finalizer). A draw is a pure function of its key,
+// e.g. (seed, instance, note, loop iteration), so results do not depend on call order,
+// thread or block size and can be computed in any order or in parallel.
+struct CounterRng{
+  static constexpr uint64_t mix(uint64_t z){
+    z += 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+  static constexpr uint64_t hash(uint64_t seed, uint64_t a, uint64_t b = 0, uint64_t c = 0){
+    return mix(mix(mix(mix(seed) ^ a) ^ b) ^ c);
+  }
+  // [0, 1) with 24 bits of resolution.
+  static constexpr float unit(uint64_t h){ return (float)(h >> 40) * (1.0f / 16777216.0f); }
+  // [-1, 1)
+  static constexpr float bipolar(uint64_t h){ return unit(h) * 2.0f - 1.0f; }
+};
+} // namespace
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+namespace mydaw::dsp {
+// Voice mixing kernels, four lanes at a time through GCC/Clang vector extensions (SSE on x86,
+// NEON on ARM) with a scalar tail. The gain ramps linearly: frame i is scaled by g + i*gStep.
+// Pitched (resampling) mixes are in Resampler.h.
+using f4 = float __attribute__((vector_size(16)));
+using i4 = int32_t __attribute__((vector_size(16)));
+inline f4 load4(const float* p){ f4 v; std::memcpy(&v, p, sizeof v); return v; }
+inline void store4(float* p, f4 v){ std::memcpy(p, &v, sizeof v); }
+// out[i] += src[i] * gain(i)
+inline void mix_ramp(float* __restrict out, const float* __restrict src, float g, float gStep, int n){
+  const f4 step4 = f4{} + 4.0f*gStep;
+  f4 gain = f4{g, g + gStep, g + 2*gStep, g + 3*gStep};
+  int i = 0;
+  for (; i + 4 <= n; i += 4, gain += step4) store4(out + i, load4(out + i) + load4(src + i) * gain);
+  for (; i < n; ++i) out[i] += src[i] * (g + (float)i*gStep);
+}
+} // namespace
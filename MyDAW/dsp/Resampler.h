@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "Mix.h"
+namespace mydaw::dsp {
+// Interpolation for pitched sample playback, cheapest first: linear, 4-point cubic
+// (Catmull-Rom), and 8/16/32-tap windowed sinc from polyphase tables.
+enum class Interp : uint8_t{ Linear, Cubic, Sinc8, Sinc16, Sinc32 };
+constexpr Interp kInterps[] = {Interp::Linear, Interp::Cubic, Interp::Sinc8, Interp::Sinc16, Interp::Sinc32};
+constexpr int interp_taps(Interp q){ return q == Interp::Linear ? 2 : q == Interp::Cubic ? 4 : q == Interp::Sinc8 ? 8 : q == Interp::Sinc16 ? 16 : 32; }
+constexpr const char* interp_name(Interp q){
+  return q == Interp::Linear ? "linear" : q == Interp::Cubic ? "cubic" : q == Interp::Sinc8 ? "sinc8" : q == Interp::Sinc16 ? "sinc16" : "sinc32";
+}
+// A frame at position k + frac reads source frames k - (taps/2 - 1) .. k + taps/2.
+constexpr int interp_reach_before(Interp q){ return interp_taps(q) / 2 - 1; }
+constexpr int interp_reach_after(Interp q){ return interp_taps(q) / 2; }
+constexpr int kMaxInterpReach = 16;
+
+#define MYDAW_DSP_INLINE inline __attribute__((always_inline))
+using f8 = float __attribute__((vector_size(32)));
+using s8 = int16_t __attribute__((vector_size(16)));
+using s4 = int16_t __attribute__((vector_size(8)));
+// Source samples as float; 16-bit sources have full scale 32768.
+MYDAW_DSP_INLINE float to_float(float s){ return s; }
+MYDAW_DSP_INLINE float to_float(int16_t s){ return (float)s * (1.0f / 32768.0f); }
+// 256-bit values go through references: returning them by value changes the ABI with AVX.
+MYDAW_DSP_INLINE void load8(f8& v, const float* p){ std::memcpy(&v, p, sizeof v); }
+MYDAW_DSP_INLINE void load8(f8& v, const int16_t* p){ s8 w; std::memcpy(&w, p, sizeof w); v = __builtin_convertvector(w, f8) * (1.0f / 32768.0f); }
+MYDAW_DSP_INLINE f4 row4(const float* p){ return load4(p); }
+MYDAW_DSP_INLINE f4 row4(const int16_t* p){ s4 w; std::memcpy(&w, p, sizeof w); return __builtin_convertvector(__builtin_convertvector(w, i4), f4) * (1.0f / 32768.0f); }
+// Source frame at, zero outside [0, frames).
+template<class T> MYDAW_DSP_INLINE float at_or_zero(const T* src, int64_t frames, int64_t at){ return at >= 0 && at < frames ? to_float(src[at]) : 0.0f; }
+
+// Kaiser-windowed sinc for Taps taps at kPhases fractional positions, each row normalised to
+// unit DC gain. A row is stored with its difference to the next one, so a frame interpolates
+// between neighbouring phases at one extra multiply-add per tap. The cutoff is fixed below
+// Nyquist; transposing far upward lets content above the new Nyquist alias.
+template<int Taps> struct SincTable{
+  static_assert(Taps % 8 == 0);
+  static constexpr int kPhases = 256;
+  static constexpr double kCutoff = Taps == 8 ? 0.75 : Taps == 16 ? 0.86 : 0.93; // of Nyquist
+  static constexpr double kBeta = Taps == 8 ? 5.0 : Taps == 16 ? 6.5 : 8.0;
+  alignas(64) float coef[kPhases][2][Taps];
+  SincTable(){
+    auto i0 = [](double x){ // modified Bessel function of the first kind, order 0
+      double sum = 1.0, term = 1.0;
+      for (int k = 1; term > 1e-12 * sum; ++k){ term *= (x / (2.0 * k)) * (x / (2.0 * k)); sum += term; }
+      return sum;
+    };
+    auto row = [&](int p, double* h){
+      const double frac = (double)p / kPhases, half = Taps / 2.0;
+      double sum = 0.0;
+      for (int j = 0; j < Taps; ++j){
+        const double x = (double)(j - (Taps / 2 - 1)) - frac; // tap distance from the frame
+        const double y = kCutoff * x;
+        const double sinc = y == 0.0 ? 1.0 : std::sin(M_PI * y) / (M_PI * y);
+        const double r = x / half;
+        h[j] = r * r < 1.0 ? kCutoff * sinc * i0(kBeta * std::sqrt(1.0 - r * r)) / i0(kBeta) : 0.0;
+        sum += h[j];
+      }
+      for (int j = 0; j < Taps; ++j) h[j] /= sum;
+    };
+    double cur[Taps], next[Taps];
+    row(0, cur);
+    for (int p = 0; p < kPhases; ++p){
+      row(p + 1, next);
+      for (int j = 0; j < Taps; ++j){ coef[p][0][j] = (float)cur[j]; coef[p][1][j] = (float)(next[j] - cur[j]); }
+      std::copy(next, next + Taps, cur);
+    }
+  }
+  // Built on first call; make that call off the audio thread (see warm_resampler()).
+  static const SincTable& get(){ static const SincTable table; return table; }
+};
+
+// acc = the Taps-tap dot product for the frame at k + (p + t)/kPhases, in eight partial sums.
+template<int Taps, class T>
+MYDAW_DSP_INLINE void sinc_dot(f8& acc, const SincTable<Taps>& tab, const T* src, int64_t frames, int64_t k, int p, float t){
+  const f8 tv = f8{} + t;
+  const float* c = tab.coef[p][0];
+  const float* d = tab.coef[p][1];
+  const int64_t first = k - (Taps / 2 - 1);
+  f8 cv, dv, xv;
+  acc = f8{};
+  if (first >= 0 && first + Taps <= frames){
+    for (int j = 0; j < Taps; j += 8){ load8(cv, c + j); load8(dv, d + j); load8(xv, src + first + j); acc += (cv + tv * dv) * xv; }
+  } else {
+    float x[Taps];
+    for (int j = 0; j < Taps; ++j) x[j] = at_or_zero(src, frames, first + j);
+    for (int j = 0; j < Taps; j += 8){ load8(cv, c + j); load8(dv, d + j); load8(xv, x + j); acc += (cv + tv * dv) * xv; }
+  }
+}
+MYDAW_DSP_INLINE f4 fold8(const f8& v){ return __builtin_shufflevector(v, v, 0, 1, 2, 3) + __builtin_shufflevector(v, v, 4, 5, 6, 7); }
+// {sum(a), sum(b), sum(c), sum(d)}
+MYDAW_DSP_INLINE f4 sum4x4(f4 a, f4 b, f4 c, f4 d){
+  const f4 ab = __builtin_shufflevector(a, b, 0, 4, 1, 5) + __builtin_shufflevector(a, b, 2, 6, 3, 7);
+  const f4 cd = __builtin_shufflevector(c, d, 0, 4, 1, 5) + __builtin_shufflevector(c, d, 2, 6, 3, 7);
+  return __builtin_shufflevector(ab, cd, 0, 1, 4, 5) + __builtin_shufflevector(ab, cd, 2, 3, 6, 7);
+}
+// Four frames per step: positions and phases as vectors, each frame's taps as 8-wide
+// multiply-adds, and the four dot products folded together before one store.
+template<int Taps, class T>
+MYDAW_DSP_INLINE double mix_sinc_body(float* __restrict out, const T* __restrict src, int64_t frames, double pos, float rate, float g, float gStep, int n){
+  constexpr int kPhases = SincTable<Taps>::kPhases;
+  const SincTable<Taps>& tab = SincTable<Taps>::get();
+  const int64_t base = (int64_t)std::floor(pos);
+  const float f0 = (float)(pos - (double)base);
+  const f4 lane{0.0f, 1.0f, 2.0f, 3.0f};
+  int i = 0;
+  for (; i + 4 <= n; i += 4){
+    const f4 fi = lane + (float)i;
+    const f4 p = f0 + fi * rate;
+    const i4 k = __builtin_convertvector(p, i4);
+    const f4 fp = (p - __builtin_convertvector(k, f4)) * (float)kPhases;
+    i4 ph = __builtin_convertvector(fp, i4);
+    ph = ph > kPhases - 1 ? kPhases - 1 : ph;
+    const f4 t = fp - __builtin_convertvector(ph, f4);
+    f8 a0, a1, a2, a3;
+    sinc_dot(a0, tab, src, frames, base + k[0], ph[0], t[0]);
+    sinc_dot(a1, tab, src, frames, base + k[1], ph[1], t[1]);
+    sinc_dot(a2, tab, src, frames, base + k[2], ph[2], t[2]);
+    sinc_dot(a3, tab, src, frames, base + k[3], ph[3], t[3]);
+    store4(out + i, load4(out + i) + sum4x4(fold8(a0), fold8(a1), fold8(a2), fold8(a3)) * (g + fi * gStep));
+  }
+  for (; i < n; ++i){
+    const float p = f0 + (float)i * rate;
+    const int k = (int)p;
+    const float fp = (p - (float)k) * (float)kPhases;
+    const int ph = std::min((int)fp, kPhases - 1);
+    f8 acc;
+    sinc_dot(acc, tab, src, frames, base + k, ph, fp - (float)ph);
+    const f4 s = fold8(acc);
+    out[i] += ((s[0] + s[2]) + (s[1] + s[3])) * (g + (float)i * gStep);
+  }
+  return pos + (double)n * rate;
+}
+// Linear and cubic work on four frames at a time, falling back to bounds-checked reads for a
+// group that touches either end of the source.
+template<class T> MYDAW_DSP_INLINE float linear_frame(const T* src, int64_t frames, int64_t k, float t){
+  const float a = at_or_zero(src, frames, k), b = at_or_zero(src, frames, k + 1);
+  return a + (b - a) * t;
+}
+template<class T> MYDAW_DSP_INLINE float cubic_frame(const T* src, int64_t frames, int64_t k, float t){
+  const float x0 = at_or_zero(src, frames, k - 1), x1 = at_or_zero(src, frames, k);
+  const float x2 = at_or_zero(src, frames, k + 1), x3 = at_or_zero(src, frames, k + 2);
+  return x1 + 0.5f * t * (x2 - x0 + t * (2.0f*x0 - 5.0f*x1 + 4.0f*x2 - x3 + t * (3.0f*(x1 - x2) + x3 - x0)));
+}
+template<bool Cubic, class T>
+MYDAW_DSP_INLINE void poly_frames(float* out, const T* src, int64_t frames, int64_t base, float f0, float rate, float g, float gStep, int from, int to){
+  for (int i = from; i < to; ++i){
+    const float p = f0 + (float)i * rate;
+    const int k = (int)p;
+    const float v = Cubic ? cubic_frame(src, frames, base + k, p - (float)k) : linear_frame(src, frames, base + k, p - (float)k);
+    out[i] += v * (g + (float)i * gStep);
+  }
+}
+template<bool Cubic, class T>
+MYDAW_DSP_INLINE double mix_poly_body(float* __restrict out, const T* __restrict src, int64_t frames, double pos, float rate, float g, float gStep, int n){
+  const int64_t base = (int64_t)std::floor(pos);
+  const float f0 = (float)(pos - (double)base);
+  const f4 lane{0.0f, 1.0f, 2.0f, 3.0f};
+  constexpr int kBefore = Cubic ? 1 : 0, kAfter = Cubic ? 2 : 1;
+  int i = 0;
+  for (; i + 4 <= n; i += 4){
+    const f4 fi = lane + (float)i;
+    const f4 p = f0 + fi * rate;
+    const i4 k = __builtin_convertvector(p, i4);
+    if (base + k[0] - kBefore < 0 || base + k[3] + kAfter >= frames){ poly_frames<Cubic>(out, src, frames, base, f0, rate, g, gStep, i, i + 4); continue; }
+    const T* s = src + base;
+    const f4 t = p - __builtin_convertvector(k, f4);
+    f4 v;
+    if constexpr (Cubic){
+      // Each frame's four taps are contiguous: load them as rows and transpose to columns.
+      const f4 r0 = row4(s + k[0] - 1), r1 = row4(s + k[1] - 1), r2 = row4(s + k[2] - 1), r3 = row4(s + k[3] - 1);
+      const f4 lo01 = __builtin_shufflevector(r0, r1, 0, 4, 1, 5), hi01 = __builtin_shufflevector(r0, r1, 2, 6, 3, 7);
+      const f4 lo23 = __builtin_shufflevector(r2, r3, 0, 4, 1, 5), hi23 = __builtin_shufflevector(r2, r3, 2, 6, 3, 7);
+      const f4 x0 = __builtin_shufflevector(lo01, lo23, 0, 1, 4, 5), x1 = __builtin_shufflevector(lo01, lo23, 2, 3, 6, 7);
+      const f4 x2 = __builtin_shufflevector(hi01, hi23, 0, 1, 4, 5), x3 = __builtin_shufflevector(hi01, hi23, 2, 3, 6, 7);
+      v = x1 + 0.5f * t * (x2 - x0 + t * (2.0f*x0 - 5.0f*x1 + 4.0f*x2 - x3 + t * (3.0f*(x1 - x2) + x3 - x0)));
+    } else {
+      const f4 a{to_float(s[k[0]]), to_float(s[k[1]]), to_float(s[k[2]]), to_float(s[k[3]])};
+      const f4 b{to_float(s[k[0]+1]), to_float(s[k[1]+1]), to_float(s[k[2]+1]), to_float(s[k[3]+1])};
+      v = a + (b - a) * t;
+    }
+    store4(out + i, load4(out + i) + v * (g + fi * gStep));
+  }
+  poly_frames<Cubic>(out, src, frames, base, f0, rate, g, gStep, i, n);
+  return pos + (double)n * rate;
+}
+
+template<Interp Q, class T>
+MYDAW_DSP_INLINE double mix_kernel(float* __restrict out, const T* __restrict src, int64_t frames, double pos, float rate, float g, float gStep, int n){
+  if constexpr (Q == Interp::Linear || Q == Interp::Cubic) return mix_poly_body<Q == Interp::Cubic>(out, src, frames, pos, rate, g, gStep, n);
+  else return mix_sinc_body<interp_taps(Q)>(out, src, frames, pos, rate, g, gStep, n);
+}
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MYDAW_DSP_AVX2 1
+// The same kernels compiled for AVX2/FMA: each 8-tap step is one 256-bit multiply-add, and
+// 16-bit sources widen with a single instruction.
+template<Interp Q, class T> __attribute__((target("avx2,fma")))
+double mix_kernel_avx2(float* __restrict out, const T* __restrict src, int64_t frames, double pos, float rate, float g, float gStep, int n){
+  return mix_kernel<Q>(out, src, frames, pos, rate, g, gStep, n);
+}
+inline bool has_avx2(){
+  static const bool yes = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  return yes;
+}
+#endif
+template<Interp Q, class T>
+double mix_dispatch(float* __restrict out, const T* __restrict src, int64_t frames, double pos, float rate, float g, float gStep, int n){
+#ifdef MYDAW_DSP_AVX2
+  if (has_avx2()) return mix_kernel_avx2<Q>(out, src, frames, pos, rate, g, gStep, n);
+#endif
+  return mix_kernel<Q>(out, src, frames, pos, rate, g, gStep, n);
+}
+
+// out[i] += src(pos + i*rate) * (g + i*gStep) for i < n, interpolated at quality q. Source
+// frames outside [0, frames) read as zero, so any position is safe. Returns pos + n*rate.
+// rate*n should stay within a few thousand frames: positions inside one call are float.
+template<class T>
+double mix_resample(Interp q, float* __restrict out, const T* __restrict src, int64_t frames, double pos, float rate, float g, float gStep, int n){
+  switch (q){
+    case Interp::Linear: return mix_dispatch<Interp::Linear>(out, src, frames, pos, rate, g, gStep, n);
+    case Interp::Cubic:  return mix_dispatch<Interp::Cubic>(out, src, frames, pos, rate, g, gStep, n);
+    case Interp::Sinc8:  return mix_dispatch<Interp::Sinc8>(out, src, frames, pos, rate, g, gStep, n);
+    case Interp::Sinc16: return mix_dispatch<Interp::Sinc16>(out, src, frames, pos, rate, g, gStep, n);
+    case Interp::Sinc32: return mix_dispatch<Interp::Sinc32>(out, src, frames, pos, rate, g, gStep, n);
+  }
+  return pos;
+}
+// Builds the sinc tables and the CPU check up front; call from prepare(), off the audio thread.
+inline void warm_resampler(){
+  SincTable<8>::get(); SincTable<16>::get(); SincTable<32>::get();
+#ifdef MYDAW_DSP_AVX2
+  has_avx2();
+#endif
+}
+} // namespace
@@ -1,16 +1,95 @@
 #include "AudioEngineRT.h"
+#include "RtSanitizer.h"
+#include <algorithm>
 namespace mydaw {
-void AudioEngineRT::process(const float* /*in*/, float* /*out*/, int frames){
-  events_.clear();
-  sched_.gather_realtime(active_, samplePos_, (uint32_t)frames, events_);
-  for (const auto& ev : events_){
-    auto bp = GenIdMapper::gen_to_pad(ev.gen);
-    switch (ev.type){
-      case mydaw::midi::EvType::NoteOn:  sampler_.note_on({bp.first,bp.second,ev.vel}); break;
-      case mydaw::midi::EvType::NoteOff: sampler_.note_off({bp.first,bp.second,ev.vel}); break;
-      case mydaw::midi::EvType::PitchBend: sampler_.pitch_bend(bp.first,bp.second,ev.pb); break;
+void AudioEngineRT::setTempo(double bpm){
+  const int64_t pos = samplePos_.load(std::memory_order_relaxed);
+  if (pos == 0 && !tb_.tempo_map()){ tb_.set(tb_.sr(), {bpm,4,4}); publish(); return; }
+  const midi::Tick now = tb_.samples_to_ticks(pos);
+  std::vector<midi::TempoPoint> pts = tb_.tempo_map() ? tb_.tempo_map()->points()
+                                                      : std::vector<midi::TempoPoint>{{0, tb_.tempo().bpm, false}};
+  const double bpmNow = tb_.bpm_at(now);
+  pts.erase(std::remove_if(pts.begin(), pts.end(), [&](const midi::TempoPoint& p){ return p.tick >= now; }), pts.end());
+  pts.push_back({now, bpmNow, false}); // closes a running ramp exactly where it is
+  pts.push_back({now, bpm, false});
+  setTempoMap(std::move(pts));
+}
+void AudioEngineRT::setTempoMap(std::vector<midi::TempoPoint> points){
+  tb_.set_tempo_map(std::make_shared<const midi::TempoMap>(std::move(points)));
+  publish();
+}
+void AudioEngineRT::publish(std::vector<midi::PatternInstance> instances, midi::InstanceIndex index){
+  state_ = std::make_shared<const EngineState>(EngineState{tb_, std::move(instances), std::move(index)});
+  live_.publish(state_);
+  if (lookahead_) lookahead_->update(state_->instances, tb_);
+}
+Tracer& AudioEngineRT::tracer(){
+  if (!tracer_){
+    tracer_ = std::make_unique<Tracer>();
+    tracer_->setName(samplerNode_, "PadSampler");
+  }
+  return *tracer_;
+}
+bool AudioEngineRT::startTrace(const std::string& path){
+  if (!tracer().start(path, tb_.sr())) return false;
+  graph_.setTracer(tracer_.get());
+  trace_.store(tracer_.get(), std::memory_order_relaxed);
+  return true;
+}
+void AudioEngineRT::stopTrace(){
+  if (!tracer_) return;
+  trace_.store(nullptr, std::memory_order_relaxed);
+  graph_.setTracer(nullptr);
+  tracer_->stop();
+}
+void AudioEngineRT::dispatch(const midi::Ev& ev){
+  auto bp = GenIdMapper::gen_to_pad(ev.gen);
+  switch (ev.type){
+    case mydaw::midi::EvType::NoteOn:  sampler_.note_on({bp.first,bp.second,ev.vel}); break;
+    case mydaw::midi::EvType::NoteOff: sampler_.note_off({bp.first,bp.second,ev.vel}); break;
+    case mydaw::midi::EvType::PitchBend: sampler_.pitch_bend(bp.first,bp.second,ev.value); break;
+    case mydaw::midi::EvType::PitchRamp: sampler_.pitch_ramp(bp.first,bp.second,ev.value,ev.value2,ev.ramp_samples()); break;
+    default: break; // controllers and MPE expression have no pad-sampler target yet
+  }
+}
+void AudioEngineRT::process(const float* in, float* out, int frames){
+  rt::RealtimeScope rtScope;
+  Tracer* tracer = trace_.load(std::memory_order_relaxed);
+  const uint64_t tBlock = tracer ? Tracer::now() : 0;
+  params_.apply_all();
+  // The scheduler's copy shares the tempo map with the snapshot, which outlives it here.
+  if (const EngineState* s = live_.acquire(); s != cur_){ cur_ = s; sched_.set_timebase(s->tb); }
+  const int64_t pos = samplePos_.load(std::memory_order_relaxed);
+  if (!lookahead_ || !lookahead_->pop_block(pos, (uint32_t)frames, events_))
+    sched_.gather_realtime(cur_->instances, pos, (uint32_t)frames, events_);
+  if (tracer) tracer->record(Tracer::kGather, tBlock, Tracer::now(), (uint32_t)frames);
+  const uint32_t* offsets = events_.offsets();
+  const size_t count = events_.size();
+  size_t i = 0;
+  for (uint32_t at = 0; at < (uint32_t)frames;){
+    for (; i < count && offsets[i] <= at; ++i) dispatch(events_[i]);
+    const uint32_t next = i < count ? std::min(std::max(offsets[i], at + minSlice_), (uint32_t)frames) : (uint32_t)frames;
+    renderAudio(in ? in + 2*(size_t)at : nullptr, out ? out + 2*(size_t)at : nullptr, (int)(next - at));
+    at = next;
+  }
+  for (; i < count; ++i) dispatch(events_[i]); // offsets are clamped below frames; kept for safety
+  samplePos_.store(pos + frames, std::memory_order_relaxed);
+  if (tracer) tracer->record(Tracer::kBlock, tBlock, Tracer::now(), (uint32_t)frames);
+}
+void AudioEngineRT::renderAudio(const float* in, float* out, int frames){
+  if (!graph_.prepared()){ if (out) std::fill(out, out + (size_t)frames*2, 0.0f); return; }
+  const int maxBlock = graph_.maxBlock();
+  for (int done = 0; done < frames; done += maxBlock){
+    const int n = std::min(maxBlock, frames - done);
+    float* const* gi = graph_.inputBuffers();
+    for (int i = 0; i < n; ++i){
+      gi[0][i] = in ? in[2*(done+i)] : 0.0f;
+      gi[1][i] = in ? in[2*(done+i)+1] : 0.0f;
     }
+    if (executor_ && executor_->attached()) executor_->process(n); else graph_.process(n);
+    if (!out) continue;
+    const float* const* go = graph_.outputBuffers();
+    for (int i = 0; i < n; ++i){ out[2*(done+i)] = go[0][i]; out[2*(done+i)+1] = go[1][i]; }
   }
-  samplePos_ += frames;
 }
 } // namespace
@@ -1,8 +1,17 @@
 #pragma once
 #include <vector>
 #include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <atomic>
 #include "midi/scheduler.hpp"
 #include "../pads/PadSampler.h"
+#include "LookaheadScheduler.h"
+#include "AudioGraph.h"
+#include "GraphExecutor.h"
+#include "SnapshotExchange.h"
+#include "ParamQueue.h"
+#include "Tracer.h"
 namespace mydaw {
 struct GenIdMapper {
   static std::pair<uint8_t,uint8_t> gen_to_pad(uint32_t gen){
@@ -10,20 +19,94 @@ struct GenIdMapper {
   }
   static uint32_t pad_to_gen(uint8_t bank, uint8_t pad){ return (uint32_t)((bank<<8)|pad); }
 };
+// Everything process() reads about the arrangement, published as one immutable snapshot.
+struct EngineState{
+  mydaw::midi::TimeBase tb;
+  std::vector<mydaw::midi::PatternInstance> instances;
+  mydaw::midi::InstanceIndex index;
+};
 class AudioEngineRT{
+  // Control thread.
   mydaw::midi::TimeBase tb_;
+  std::shared_ptr<const EngineState> state_;
+  SnapshotExchange<EngineState> live_;
+  ParamQueue params_;
+  // Audio thread.
+  const EngineState* cur_{nullptr};
   mydaw::midi::Scheduler sched_;
   mydaw::pads::PadSampler sampler_;
-  std::vector<mydaw::midi::PatternInstance> active_;
-  std::vector<midi::Ev> events_;
-  int64_t samplePos_{0};
+  midi::EventLanes events_;
+  std::atomic<int64_t> samplePos_{0};
+  std::unique_ptr<LookaheadScheduler> lookahead_;
+  AudioGraph graph_;
+  std::unique_ptr<GraphExecutor> executor_;
+  uint32_t minSlice_{16};
+  AudioGraph::NodeId samplerNode_;
+  std::unique_ptr<Tracer> tracer_;          // kept once created; the audio thread may hold it
+  std::atomic<Tracer*> trace_{nullptr};
+  void dispatch(const midi::Ev& ev);
+  void renderAudio(const float* in, float* out, int frames);
+  void publish(std::vector<mydaw::midi::PatternInstance> instances, mydaw::midi::InstanceIndex index);
+  void publish(){ publish(state_->instances, state_->index); }
 public:
-  AudioEngineRT(double sr): tb_{sr,{120.0,4,4}}, sched_{tb_} {}
-  void setTempo(double bpm){ tb_.set(tb_.sr(), {bpm,4,4}); }
-  void setSampleRate(double sr){ tb_.set(sr, tb_.tempo()); }
-  void setActivePatterns(std::vector<mydaw::midi::PatternInstance> v){ active_.swap(v); }
+  static constexpr size_t kMaxBlockEvents = 4096;
+  static constexpr size_t kMaxBlockRuns = 1024;
+  AudioEngineRT(double sr): tb_{sr,{120.0,4,4}}, sched_{tb_} {
+    events_.reserve(kMaxBlockEvents);
+    sched_.reserve(kMaxBlockEvents, kMaxBlockRuns);
+    samplerNode_ = graph_.add(&sampler_);
+    graph_.connect(samplerNode_, graph_.output());
+    publish({}, {});
+  }
+  // Plans the node graph for blocks of up to maxBlock frames. Call after editing graph().
+  bool prepare(int maxBlock){
+    const bool ok = graph_.prepare(tb_.sr(), maxBlock, executor_ != nullptr);
+    if (executor_) executor_->attach(ok ? &graph_ : nullptr);
+    return ok;
+  }
+  // Runs independent graph branches on `workers` extra threads; takes effect at the next prepare().
+  void enableParallel(int workers){ executor_ = std::make_unique<GraphExecutor>(workers); }
+  void disableParallel(){ executor_.reset(); }
+  // Scaling figures of the last block, or null when running single-threaded.
+  const GraphExecutor::Stats* parallelStats() const { return executor_ ? &executor_->lastBlock() : nullptr; }
+  // Changes tempo from the playhead on; positions already played keep their sample times.
+  void setTempo(double bpm);
+  void setTempoMap(std::vector<mydaw::midi::TempoPoint> points);
+  void setSampleRate(double sr){ tb_.set_sample_rate(sr); publish(); }
+  // Edits publish a new snapshot; the audio thread switches to it at its next block.
+  void setActivePatterns(std::vector<mydaw::midi::PatternInstance> v){
+    mydaw::midi::Scheduler::compile_timelines(v);
+    mydaw::midi::InstanceIndex index(v);
+    publish(std::move(v), std::move(index));
+  }
+  // Queues a numeric plugin setting, e.g. setParam<&MomentumDelay::setFeedback>(delay, 0.4f);
+  // it is applied on the audio thread before the next block. False when the queue is full.
+  template<auto Set, class P> bool setParam(P& node, float value){ return params_.push(make_param<Set>(node, value)); }
+  // Times callbacks, event gathering and every graph node into a Chrome/Perfetto trace at path
+  // (empty: histograms only). Name your nodes through tracer().setName(NodeId, ...). The thread
+  // that calls process() must have called Tracer::attach(); the parallel workers attach themselves.
+  bool startTrace(const std::string& path);
+  void stopTrace();
+  Tracer& tracer();
+  // Control thread: frees snapshots the audio thread has retired and pooled audio nobody uses.
+  // publish() also frees snapshots.
+  void collectGarbage(){ live_.collect(); sampler_.collect(); sample::SamplePool::shared().collect(); }
+  // Optional: pre-gather events lookaheadBlocks ahead on a worker thread. Call while stopped;
+  // blocks the worker has not covered yet are gathered inline.
+  void enableLookahead(int blockSize, int lookaheadBlocks){
+    lookahead_ = std::make_unique<LookaheadScheduler>(tb_, blockSize, lookaheadBlocks, kMaxBlockEvents);
+    publish();
+  }
+  void disableLookahead(){ lookahead_.reset(); }
+  // in/out are interleaved stereo and may be null. Audio runs only once prepare() succeeded.
+  // The block is rendered in slices split at event offsets, so events take effect on their
+  // sample; slices are at least minSlice long, later events in that window wait for its end.
   void process(const float* in, float* out, int frames);
+  void setMinSlice(uint32_t frames){ minSlice_ = std::max<uint32_t>(frames, 1); }
   mydaw::pads::PadSampler& sampler(){ return sampler_; }
+  AudioGraph& graph(){ return graph_; }
   mydaw::midi::Scheduler& scheduler(){ return sched_; }
+  const mydaw::midi::InstanceIndex& instanceIndex() const { return state_->index; }
+  uint64_t eventOverflows() const { return events_.overflow_count(); }
 };
 } // namespace
@@ -0,0 +1,164 @@
+#include "AudioGraph.h"
+#include "RtSanitizer.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cstring>
+namespace mydaw {
+AudioGraph::AudioGraph(){ nodes_.resize(2); }
+AudioGraph::NodeId AudioGraph::add(Node* node){
+  nodes_.push_back(Vertex{node, {}});
+  prepared_ = false;
+  return (NodeId)nodes_.size() - 1;
+}
+void AudioGraph::connect(NodeId src, NodeId dst){
+  nodes_[dst].inputs.push_back(src);
+  prepared_ = false;
+}
+bool AudioGraph::prepare(double sr, int maxBlock, bool parallelSafe){
+  prepared_ = false;
+  sr_ = sr; maxBlock_ = maxBlock;
+  const size_t n = nodes_.size();
+  // Kahn's algorithm with a LIFO ready set: finishing one chain before starting the next keeps
+  // fewer outputs alive at once. The input pseudo-node always runs first.
+  std::vector<std::vector<NodeId>> readers(n);
+  std::vector<int> pending(n, 0);
+  for (size_t v = 0; v < n; ++v) for (NodeId s : nodes_[v].inputs){ readers[s].push_back((NodeId)v); ++pending[v]; }
+  std::vector<NodeId> order, ready; order.reserve(n);
+  for (size_t v = n; v-- > 0;) if (pending[v]==0) ready.push_back((NodeId)v);
+  while (!ready.empty()){
+    const NodeId v = ready.back(); ready.pop_back();
+    order.push_back(v);
+    for (auto r = readers[v].rbegin(); r != readers[v].rend(); ++r) if (--pending[*r]==0) ready.push_back(*r);
+  }
+  if (order.size() != n || order[0] != input()) return false;
+  for (auto& v : nodes_) if (v.node) v.node->prepare(sr, maxBlock);
+
+  // Path latency at each node's output, and the delay each edge needs to line up at its reader.
+  std::vector<int> lat(n, 0), arrive(n, 0), pos(n, 0), lastRead(n, -1);
+  for (size_t i = 0; i < order.size(); ++i){
+    const NodeId v = order[i]; pos[v] = (int)i;
+    for (NodeId s : nodes_[v].inputs) arrive[v] = std::max(arrive[v], lat[s]);
+    lat[v] = arrive[v] + (nodes_[v].node ? nodes_[v].node->latencySamples() : 0);
+  }
+  for (size_t v = 0; v < n; ++v) for (NodeId s : nodes_[v].inputs) lastRead[s] = std::max(lastRead[s], pos[v]);
+  latency_ = lat[output()];
+
+  // Ancestor sets, only needed to keep buffer reuse safe under concurrent execution.
+  const size_t words = (n + 63) / 64;
+  std::vector<uint64_t> anc(parallelSafe ? n * words : 0, 0);
+  auto precedes = [&](NodeId a, NodeId v){ return a == v || (anc[(size_t)v*words + (size_t)a/64] >> (a%64) & 1); };
+  if (parallelSafe){
+    for (NodeId v : order) for (NodeId s : nodes_[v].inputs){
+      for (size_t w = 0; w < words; ++w) anc[(size_t)v*words + w] |= anc[(size_t)s*words + w];
+      anc[(size_t)v*words + (size_t)s/64] |= uint64_t{1} << (s%64);
+    }
+  }
+
+  // Liveness: walk the schedule handing out pool buffers and returning them after last use.
+  // Each free buffer remembers the nodes that last touched it; a parallel-safe plan hands it
+  // only to a node all of them precede, so they are finished before it is overwritten.
+  struct Free{ int buf; std::vector<NodeId> users; };
+  std::vector<Free> freeList;
+  std::vector<int> outBuf(n, -1);
+  int poolCount = 0;
+  auto take = [&](NodeId v){
+    for (size_t k = freeList.size(); k-- > 0;){
+      const auto& u = freeList[k].users;
+      if (parallelSafe && !std::all_of(u.begin(), u.end(), [&](NodeId a){ return a != v && precedes(a, v); })) continue;
+      const int b = freeList[k].buf; freeList.erase(freeList.begin() + (std::ptrdiff_t)k);
+      return b;
+    }
+    return poolCount++;
+  };
+  std::vector<Step> steps; delays_.clear();
+  std::vector<int> stepOf(n, -1);
+  outBuf[input()] = take(input());
+  for (size_t i = 1; i < order.size(); ++i){
+    const NodeId v = order[i];
+    Step st{v, -1, {}, -1, {}, {}, false, 0, {}};
+    const auto& ins = nodes_[v].inputs;
+    const bool direct = ins.size()==1 && lat[ins[0]]==arrive[v] && v != output();
+    if (direct) st.inBuf = outBuf[ins[0]];
+    else if (!ins.empty()){
+      st.inBuf = take(v);
+      for (NodeId s : ins){
+        int d = -1;
+        if (const int len = arrive[v] - lat[s]; len > 0){
+          DelayLine dl; for (auto& r : dl.ring) r.assign((size_t)len, 0.0f);
+          delays_.push_back(std::move(dl)); d = (int)delays_.size() - 1;
+        }
+        st.sum.push_back(Source{outBuf[s], d});
+      }
+    }
+    // In place: a summed input is private to v; a direct one must have no later reader (and,
+    // when steps may run concurrently, no other reader at all).
+    const Node* node = nodes_[v].node;
+    st.inPlace = node && node->processesInPlace() && st.inBuf >= 0 &&
+                 (!direct || (lastRead[ins[0]] == (int)i && (!parallelSafe || readers[ins[0]].size() == 1)));
+    // The output pseudo-node's result is its summed input (silence when nothing is connected).
+    st.outBuf = (v == output() || st.inPlace) ? st.inBuf : take(v);
+    outBuf[v] = st.outBuf;
+    if (!st.sum.empty() && st.inBuf != st.outBuf) freeList.push_back(Free{st.inBuf, {v}});
+    for (size_t k = 0; k < ins.size(); ++k){
+      const NodeId s = ins[k];
+      if (std::find(ins.begin(), ins.begin() + (std::ptrdiff_t)k, s) != ins.begin() + (std::ptrdiff_t)k) continue; // repeated edge
+      if (const int p = stepOf[s]; p >= 0){ ++st.deps; steps[(size_t)p].next.push_back((int)steps.size()); }
+      if (lastRead[s] == (int)i && outBuf[s] != st.outBuf) freeList.push_back(Free{outBuf[s], readers[s]});
+    }
+    if (lastRead[v] < 0 && v != output()) freeList.push_back(Free{st.outBuf, {v}}); // nobody reads it
+    stepOf[v] = (int)steps.size();
+    steps.push_back(std::move(st));
+  }
+
+  poolCount_ = (size_t)poolCount;
+  stride_ = AudioBlock::padded(maxBlock);
+  constexpr size_t kAlignFloats = AudioBlock::kAlign / sizeof(float);
+  pool_.assign((poolCount_ * kChannels + 1) * (size_t)stride_ + kAlignFloats, 0.0f);
+  const size_t misalign = reinterpret_cast<uintptr_t>(pool_.data()) % AudioBlock::kAlign / sizeof(float);
+  poolBase_ = pool_.data() + (misalign ? kAlignFloats - misalign : 0);
+  silence_ = chan((int)poolCount_, 0);
+  for (auto& st : steps){
+    for (int c = 0; c < kChannels; ++c){
+      st.in[c] = st.inBuf >= 0 ? chan(st.inBuf, c) : silence_;
+      st.out[c] = st.outBuf >= 0 ? chan(st.outBuf, c) : silence_;
+    }
+  }
+  for (int c = 0; c < kChannels; ++c){
+    inPtr_[c] = chan(outBuf[input()], c);
+    outPtr_[c] = outBuf[output()] >= 0 ? chan(outBuf[output()], c) : silence_;
+  }
+  steps_ = std::move(steps);
+  prepared_ = true;
+  return true;
+}
+void AudioGraph::process(int frames){
+  if (!prepared_) return;
+  rt::RealtimeScope rtScope;
+  for (size_t i = 0; i < steps_.size(); ++i) runStep(i, frames);
+}
+void AudioGraph::runStep(size_t i, int frames){
+  Step& st = steps_[i];
+  if (!st.sum.empty()){
+    for (int c = 0; c < kChannels; ++c) std::memset(st.in[c], 0, sizeof(float)*(size_t)frames);
+    for (const auto& src : st.sum){
+      for (int c = 0; c < kChannels; ++c){
+        const float* s = chan(src.buf, c); float* d = st.in[c];
+        if (src.delay < 0){ for (int k = 0; k < frames; ++k) d[k] += s[k]; continue; }
+        DelayLine& dl = delays_[src.delay];
+        std::vector<float>& ring = dl.ring[c];
+        const int len = (int)ring.size();
+        int p = dl.pos;
+        for (int k = 0; k < frames; ++k){ d[k] += ring[p]; ring[p] = s[k]; if (++p == len) p = 0; }
+        if (c == kChannels - 1) dl.pos = p;
+      }
+    }
+  }
+  if (Node* node = nodes_[st.id].node){
+    AudioBlock blk{st.in.data(), st.out.data(), frames, sr_, kChannels, AudioBlock::padded(frames), st.inPlace};
+    Tracer* tracer = tracer_.load(std::memory_order_relaxed);
+    const uint64_t t0 = tracer ? Tracer::now() : 0;
+    node->process(blk);
+    if (tracer) tracer->record(st.id, t0, Tracer::now(), (uint32_t)frames);
+  }
+}
+} // namespace
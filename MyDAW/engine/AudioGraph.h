@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "Node.h"
+namespace mydaw {
+class Tracer;
+// DAG of Nodes run in topological order. Two pseudo-nodes are built in: input() carries the
+// engine input, output() sums everything connected to it. prepare() plans the schedule once:
+// node outputs share scratch buffers from a pool sized by liveness analysis (a buffer is free
+// again after its last reader ran), and every edge that arrives early relative to its siblings
+// gets a delay line so all paths into a node are latency-aligned. Planned with parallelSafe,
+// a buffer is only reused by a node that every earlier user of it precedes in the graph, so
+// independent steps may run concurrently (see GraphExecutor). Channel buffers are 64-byte
+// aligned and padded to AudioBlock::padded(maxBlock); a node that processesInPlace() writes
+// straight into its input buffer when it is that buffer's last reader.
+class AudioGraph{
+public:
+  using NodeId = int;
+  static constexpr int kChannels = 2;
+  AudioGraph();
+  NodeId input() const { return 0; }
+  NodeId output() const { return 1; }
+  NodeId add(Node* node);
+  void connect(NodeId src, NodeId dst);
+  // Prepares every node and plans the schedule. Returns false if the graph has a cycle.
+  bool prepare(double sr, int maxBlock, bool parallelSafe = false);
+  bool prepared() const { return prepared_; }
+  int maxBlock() const { return maxBlock_; }
+  // Channel pointers of the input pseudo-node; fill before process().
+  float* const* inputBuffers(){ return inPtr_.data(); }
+  void process(int frames);
+  // Schedule introspection for executors: step i may run once stepDeps(i) predecessors finished.
+  size_t stepCount() const { return steps_.size(); }
+  int stepDeps(size_t i) const { return steps_[i].deps; }
+  const std::vector<int>& stepNext(size_t i) const { return steps_[i].next; }
+  void runStep(size_t i, int frames);
+  const float* const* outputBuffers() const { return outPtr_.data(); }
+  int latencySamples() const { return latency_; }
+  size_t poolBuffers() const { return poolCount_; }
+  size_t nodeCount() const { return nodes_.size(); }
+  // Times every Node::process into the tracer under its NodeId; null turns it off.
+  void setTracer(Tracer* tracer){ tracer_.store(tracer, std::memory_order_relaxed); }
+private:
+  struct Vertex{ Node* node{nullptr}; std::vector<NodeId> inputs; };
+  struct DelayLine{ std::array<std::vector<float>,kChannels> ring; int pos{0}; };
+  struct Source{ int buf; int delay; }; // delay: index into delays_, or -1
+  struct Step{
+    NodeId id; int outBuf;
+    std::vector<Source> sum;           // empty: inBuf is read directly
+    int inBuf;                         // -1: silence
+    std::array<float*,kChannels> in{}, out{};
+    bool inPlace{false};               // outBuf == inBuf
+    int deps{0}; std::vector<int> next; // step-level dependency edges
+  };
+  std::vector<Vertex> nodes_;
+  std::vector<Step> steps_;
+  std::vector<DelayLine> delays_;
+  std::vector<float> pool_;             // poolCount_ buffers, then one silent channel
+  float* poolBase_{nullptr};            // pool_ rounded up to AudioBlock::kAlign
+  float* silence_{nullptr};
+  std::array<float*,kChannels> inPtr_{}, outPtr_{};
+  size_t poolCount_{0};
+  int maxBlock_{0}; int stride_{0}; int latency_{0}; double sr_{48000.0};
+  bool prepared_{false};
+  std::atomic<Tracer*> tracer_{nullptr};
+  float* chan(int buf, int ch){ return poolBase_ + ((size_t)buf*kChannels + ch) * (size_t)stride_; }
+};
+} // namespace
@@ -0,0 +1,117 @@
+#include "GraphExecutor.h"
+#include "RtSanitizer.h"
+#include "Tracer.h"
+#include <chrono>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+namespace mydaw {
+namespace {
+inline int64_t now_ns(){ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+inline void cpu_relax(){
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+constexpr int kSpinBeforePark = 4096;
+} // namespace
+GraphExecutor::GraphExecutor(int workers): workerCount_(workers < 0 ? 0 : workers),
+  slots_(new Slot[(size_t)workerCount_ + 1]) {}
+GraphExecutor::~GraphExecutor(){ stop(); }
+void GraphExecutor::start(){
+  run_.store(true);
+  // Read before the thread exists: a stop() that bumps the epoch before the worker first runs
+  // must still wake it.
+  const uint32_t seen = epoch_.load(std::memory_order_acquire);
+  for (int w = 1; w <= workerCount_; ++w){
+    workers_.emplace_back([this, w, seen]{ Tracer::attach(); workerLoop(w, seen); Tracer::detach(); });
+#ifdef __linux__
+    const unsigned cpus = std::thread::hardware_concurrency();
+    if (cpus > 1){
+      cpu_set_t set; CPU_ZERO(&set); CPU_SET((unsigned)w % cpus, &set);
+      pthread_setaffinity_np(workers_.back().native_handle(), sizeof(set), &set); // best effort
+    }
+#endif
+  }
+}
+void GraphExecutor::stop(){
+  run_.store(false);
+  epoch_.fetch_add(1, std::memory_order_release);
+  epoch_.notify_all();
+  for (auto& t : workers_) t.join();
+  workers_.clear();
+}
+void GraphExecutor::attach(AudioGraph* graph){
+  stop();
+  graph_ = graph && graph->prepared() ? graph : nullptr;
+  roots_.clear();
+  const size_t n = graph_ ? graph_->stepCount() : 0;
+  pending_.reset(new std::atomic<int>[n ? n : 1]);
+  for (size_t i = 0; i < n; ++i) if (graph_->stepDeps(i) == 0) roots_.push_back((int)i);
+  for (int s = 0; s <= workerCount_; ++s) slots_[s].dq.reset(n);
+  stats_ = Stats{};
+  stats_.threads = threads();
+  start();
+}
+void GraphExecutor::process(int frames){
+  if (!graph_) return;
+  const int64_t t0 = now_ns();
+  const size_t n = graph_->stepCount();
+  frames_.store(frames, std::memory_order_relaxed);
+  for (size_t i = 0; i < n; ++i) pending_[i].store(graph_->stepDeps(i), std::memory_order_relaxed);
+  for (int s = 0; s <= workerCount_; ++s){ slots_[s].workNs = 0; slots_[s].tasks = 0; slots_[s].steals = 0; }
+  remaining_.store((int)n, std::memory_order_release);
+  for (auto r = roots_.rbegin(); r != roots_.rend(); ++r) slots_[0].dq.push(*r);
+  // seq_cst against the workers' parked_ increment: either they see the new epoch and don't
+  // sleep, or this sees them parked and makes the wake syscall.
+  epoch_.fetch_add(1);
+  if (parked_.load() > 0) epoch_.notify_all();
+  drain(0);
+  Stats st; st.threads = threads();
+  st.wallUs = (double)(now_ns() - t0) * 1e-3;
+  for (int s = 0; s <= workerCount_; ++s){
+    st.workUs += (double)slots_[s].workNs * 1e-3;
+    st.tasks += slots_[s].tasks; st.steals += slots_[s].steals;
+  }
+  stats_ = st;
+}
+void GraphExecutor::workerLoop(int slot, uint32_t seen){
+  for (;;){
+    for (int spin = 0; spin < kSpinBeforePark && epoch_.load(std::memory_order_acquire) == seen; ++spin) cpu_relax();
+    parked_.fetch_add(1);
+    epoch_.wait(seen); // returns at once if the epoch moved since the spin
+    parked_.fetch_sub(1, std::memory_order_relaxed);
+    seen = epoch_.load(std::memory_order_acquire);
+    if (!run_.load(std::memory_order_acquire)) return;
+    drain(slot);
+  }
+}
+void GraphExecutor::drain(int slot){
+  rt::RealtimeScope rtScope;
+  Slot& me = slots_[slot];
+  const uint32_t others = (uint32_t)workerCount_;
+  while (remaining_.load(std::memory_order_acquire) > 0){
+    int task = me.dq.pop();
+    for (uint32_t k = 0; task == WorkStealingDeque::kEmpty && k < others; ++k){
+      me.victim = (me.victim + 1) % (others + 1);
+      if ((int)me.victim == slot) me.victim = (me.victim + 1) % (others + 1);
+      if ((task = slots_[me.victim].dq.steal()) != WorkStealingDeque::kEmpty) ++me.steals;
+    }
+    if (task == WorkStealingDeque::kEmpty){ cpu_relax(); continue; }
+    runTask(slot, task);
+  }
+}
+void GraphExecutor::runTask(int slot, int step){
+  Slot& me = slots_[slot];
+  const int64_t t0 = now_ns();
+  graph_->runStep((size_t)step, frames_.load(std::memory_order_relaxed));
+  me.workNs += now_ns() - t0;
+  ++me.tasks;
+  for (int next : graph_->stepNext((size_t)step))
+    if (pending_[next].fetch_sub(1, std::memory_order_acq_rel) == 1) me.dq.push(next);
+  remaining_.fetch_sub(1, std::memory_order_acq_rel);
+}
+} // namespace
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "AudioGraph.h"
+#include "WorkStealingDeque.h"
+namespace mydaw {
+// Runs an AudioGraph's steps on the audio thread plus a pool of pinned workers. Each step holds
+// an atomic count of unfinished predecessors; whoever finishes the last one pushes the step on
+// its own deque, and idle threads steal from the others. process() takes no locks and does not
+// allocate; parked workers are woken through the block epoch, spinning briefly first so
+// back-to-back callbacks rarely need a wake-up, and the wake is skipped while none is parked. The graph must be prepared parallel-safe.
+class GraphExecutor{
+public:
+  struct Stats{
+    double wallUs{0};   // time spent in process()
+    double workUs{0};   // node time summed over all threads
+    uint32_t tasks{0};
+    uint32_t steals{0};
+    int threads{1};
+    // Effective parallelism of the block; threads is the ceiling.
+    double speedup() const { return wallUs > 0 ? workUs / wallUs : 0.0; }
+  };
+  // workers: threads in addition to the one calling process().
+  explicit GraphExecutor(int workers);
+  ~GraphExecutor();
+  GraphExecutor(const GraphExecutor&)=delete;
+  GraphExecutor& operator=(const GraphExecutor&)=delete;
+  // Control thread, never during process(): adopt a graph prepared with parallelSafe (or detach
+  // with nullptr). Restarts the workers so no thread still looks at the old schedule.
+  void attach(AudioGraph* graph);
+  // Audio thread: one block through the attached graph.
+  void process(int frames);
+  bool attached() const { return graph_ != nullptr; }
+  const Stats& lastBlock() const { return stats_; }
+  int threads() const { return workerCount_ + 1; }
+private:
+  struct alignas(64) Slot{ WorkStealingDeque dq; int64_t workNs{0}; uint32_t tasks{0}, steals{0}; uint32_t victim{0}; };
+  const int workerCount_;
+  AudioGraph* graph_{nullptr};
+  std::unique_ptr<Slot[]> slots_;
+  std::unique_ptr<std::atomic<int>[]> pending_;
+  std::vector<int> roots_;
+  alignas(64) std::atomic<int> remaining_{0};
+  alignas(64) std::atomic<uint32_t> epoch_{0};
+  std::atomic<int> parked_{0};   // workers in (or about to enter) epoch_.wait
+  std::atomic<bool> run_{false};
+  std::atomic<int> frames_{0};
+  std::vector<std::thread> workers_;
+  Stats stats_;
+  void start();
+  void stop();
+  void workerLoop(int slot, uint32_t seen);
+  void drain(int slot);
+  void runTask(int slot, int step);
+};
+} // namespace
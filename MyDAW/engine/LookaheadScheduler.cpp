@@ -0,0 +1,67 @@
+#include "LookaheadScheduler.h"
+#include <chrono>
+#include <algorithm>
+namespace mydaw {
+LookaheadScheduler::LookaheadScheduler(const midi::TimeBase& tb, int blockSize, int lookaheadBlocks, size_t maxBlockEvents)
+  : queue_((size_t)(lookaheadBlocks + 1) * (maxBlockEvents + 1)), blockSize_(blockSize),
+    lookahead_((int64_t)lookaheadBlocks * blockSize), maxChunkEvents_(maxBlockEvents), tb_(tb){
+  worker_ = std::thread([this]{ work(); });
+}
+LookaheadScheduler::~LookaheadScheduler(){
+  run_.store(false);
+  worker_.join();
+}
+void LookaheadScheduler::update(const std::vector<midi::PatternInstance>& instances, const midi::TimeBase& tb){
+  std::lock_guard<std::mutex> lk(mu_);
+  instances_ = instances;
+  tb_ = tb;
+  gen_.fetch_add(1, std::memory_order_release);
+}
+void LookaheadScheduler::work(){
+  midi::Scheduler sched{midi::TimeBase{}};
+  sched.reserve(maxChunkEvents_, maxChunkEvents_);
+  midi::EventLanes chunk; chunk.reserve(maxChunkEvents_);
+  std::vector<midi::PatternInstance> instances;
+  uint32_t gen = 0;
+  int64_t produced = 0;
+  while (run_.load(std::memory_order_relaxed)){
+    if (gen_.load(std::memory_order_acquire) != gen){
+      std::lock_guard<std::mutex> lk(mu_);
+      gen = gen_.load(std::memory_order_relaxed);
+      instances = instances_;
+      sched.set_timebase(tb_);
+      produced = playPos_.load(std::memory_order_acquire);
+    }
+    const int64_t playPos = playPos_.load(std::memory_order_acquire);
+    produced = std::max(produced, playPos); // fell behind: the audio thread gathered those inline
+    const int64_t target = playPos + lookahead_;
+    if (produced >= target || queue_.free_slots() < maxChunkEvents_ + 1){
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    sched.gather_realtime(instances, produced, (uint32_t)blockSize_, chunk);
+    for (size_t i = 0; i < chunk.size(); ++i){ const midi::Ev e = chunk[i]; queue_.push(QueuedEv{produced + e.sampOff, gen, false, e}); }
+    produced += blockSize_;
+    queue_.push(QueuedEv{produced, gen, true, {}});
+  }
+}
+bool LookaheadScheduler::pop_block(int64_t blockSample, uint32_t frames, midi::EventLanes& out){
+  out.clear();
+  const int64_t blockEnd = blockSample + frames;
+  const uint32_t gen = gen_.load(std::memory_order_acquire);
+  if (gen != consumerGen_){ consumerGen_ = gen; covered_ = INT64_MIN; }
+  while (const QueuedEv* q = queue_.front()){
+    if (q->gen != gen){ queue_.pop(); continue; }
+    if (q->sample >= blockEnd) break;
+    if (q->marker) covered_ = q->sample;
+    else if (q->sample >= blockSample){ midi::Ev e = q->ev; e.sampOff = (uint32_t)(q->sample - blockSample); out.push(e); }
+    queue_.pop();
+  }
+  // Published only after consuming, so the worker never skips past events still due here.
+  playPos_.store(blockEnd, std::memory_order_release);
+  const QueuedEv* next = queue_.front();
+  if (covered_ >= blockEnd || (next && next->gen == gen)) return true;
+  out.clear();
+  return false;
+}
+} // namespace
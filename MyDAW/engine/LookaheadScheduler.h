@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "midi/scheduler.hpp"
+#include "SpscQueue.h"
+namespace mydaw {
+// Gathers events ahead of the playhead on a non-realtime worker and hands them to the audio
+// thread through an SPSC ring, so scheduling CPU leaves the callback. Every edit bumps a
+// generation; queued events of older generations are dropped by the consumer, and a block the
+// worker has not covered yet is reported as such so the caller can gather it inline.
+class LookaheadScheduler{
+  struct QueuedEv{ int64_t sample; uint32_t gen; bool marker; midi::Ev ev; }; // marker: chunk end at `sample`
+  SpscQueue<QueuedEv> queue_;
+  const int blockSize_;
+  const int64_t lookahead_;
+  const size_t maxChunkEvents_;
+  // Control thread -> worker, under mu_.
+  std::mutex mu_;
+  std::vector<midi::PatternInstance> instances_;
+  midi::TimeBase tb_;
+  std::atomic<uint32_t> gen_{1};
+  // Audio thread -> worker.
+  std::atomic<int64_t> playPos_{0};
+  std::atomic<bool> run_{true};
+  // Audio-thread only.
+  uint32_t consumerGen_{0};
+  int64_t covered_{0};
+  std::thread worker_;
+  void work();
+public:
+  LookaheadScheduler(const midi::TimeBase& tb, int blockSize, int lookaheadBlocks, size_t maxBlockEvents);
+  ~LookaheadScheduler();
+  LookaheadScheduler(const LookaheadScheduler&)=delete;
+  LookaheadScheduler& operator=(const LookaheadScheduler&)=delete;
+  // Control thread: publish new state and invalidate everything queued.
+  void update(const std::vector<midi::PatternInstance>& instances, const midi::TimeBase& tb);
+  // Audio thread: moves the events due in [blockSample, blockSample+frames) into out.
+  // Returns false (out cleared) when the worker has not covered the whole block yet.
+  bool pop_block(int64_t blockSample, uint32_t frames, midi::EventLanes& out);
+};
+} // namespace
@@ -1,3 +1,22 @@
 #pragma once
-struct AudioBlock{ float** in; float** out; int frames; double sr; };
-struct Node{ virtual ~Node(){}; virtual void prepare(double,int)=0; virtual void process(const AudioBlock&)=0; virtual int latencySamples() const=0; };
+#include <cstddef>
+// Planar audio for one process() call. Buffers planned by AudioGraph are kAlign-byte aligned
+// and hold paddedFrames floats per channel (frames rounded up to whole 64-byte lines), so
+// vector loops may run to paddedFrames; whatever they write past `frames` is ignored. A
+// zero paddedFrames promises nothing beyond `frames`. With inPlace, out[c] == in[c].
+struct AudioBlock{
+  static constexpr size_t kAlign = 64;
+  static constexpr int kPadFrames = (int)(kAlign / sizeof(float));
+  static constexpr int padded(int frames){ return (frames + kPadFrames - 1) / kPadFrames * kPadFrames; }
+  float** in; float** out; int frames; double sr;
+  int channels{2}; int paddedFrames{0}; bool inPlace{false};
+};
+// processesInPlace(): the node copes with out == in, so the graph may hand it its input buffer
+// as output when nothing else still reads that input.
+struct Node{
+  virtual ~Node(){};
+  virtual void prepare(double,int)=0;
+  virtual void process(const AudioBlock&)=0;
+  virtual int latencySamples() const=0;
+  virtual bool processesInPlace() const { return false; }
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include "Node.h"
+#include "SpscQueue.h"
+namespace mydaw {
+// A parameter change for a node, applied on the audio thread between blocks so plugin setters
+// never race process(). Built by make_param<&Plugin::setX>(plugin, value); plain data, so the
+// queue carrying it stays allocation-free.
+struct ParamCommand{ void (*apply)(Node*, float); Node* target; float value; };
+template<auto Set, class P>
+ParamCommand make_param(P& node, float value){
+  return ParamCommand{[](Node* n, float v){ (static_cast<P*>(n)->*Set)(v); }, &node, value};
+}
+// Single control thread -> audio thread.
+class ParamQueue{
+  SpscQueue<ParamCommand> queue_;
+public:
+  explicit ParamQueue(size_t capacity = 256): queue_(capacity) {}
+  // Control thread. Returns false when the queue is full; the caller may retry.
+  bool push(const ParamCommand& c){ return queue_.push(c); }
+  // Audio thread.
+  void apply_all(){
+    while (const ParamCommand* c = queue_.front()){ c->apply(c->target, c->value); queue_.pop(); }
+  }
+};
+} // namespace
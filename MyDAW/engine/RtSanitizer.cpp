@@ -0,0 +1,130 @@
+#include "RtSanitizer.h"
+#ifdef MYDAW_RT_SANITIZER
+// Interposes the libc entry points below; the executable's definitions win over libc's for
+// every caller, plugins included. Allocation forwards to glibc's __libc_* so no dlsym is needed
+// on the allocation path; everything else resolves the real symbol with RTLD_NEXT.
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+extern "C" {
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void __libc_free(void*);
+}
+namespace mydaw::rt {
+namespace {
+thread_local int depth = 0;     // open RealtimeScopes on this thread
+thread_local bool reporting = false;
+std::atomic<unsigned long> count{0};
+constexpr int kMaxTraces = 256;
+std::atomic<uint64_t> seen[kMaxTraces];
+bool remember(uint64_t key){ // false when this trace was reported already
+  for (auto& s : seen){
+    uint64_t cur = s.load(std::memory_order_relaxed);
+    if (cur == key) return false;
+    if (cur == 0 && s.compare_exchange_strong(cur, key)) return true;
+    if (cur == key) return false;
+  }
+  return true;
+}
+void at_exit(){
+  const unsigned long n = count.load();
+  if (!n) return;
+  std::fprintf(stderr, "rt-sanitizer: %lu real-time violation(s)\n", n);
+  std::_Exit(kViolationExit);
+}
+void violation(const char* what){
+  if (depth == 0 || reporting) return;
+  reporting = true;
+  if (count.fetch_add(1) == 0) std::atexit(at_exit);
+  void* frames[32];
+  const int n = backtrace(frames, 32);
+  uint64_t key = 1469598103934665603ull;
+  for (int i = 0; i < n; ++i) key = (key ^ (uint64_t)(uintptr_t)frames[i]) * 1099511628211ull;
+  if (remember(key ? key : 1)){
+    std::fprintf(stderr, "rt-sanitizer: %s inside a real-time scope\n", what);
+    backtrace_symbols_fd(frames + 1, n - 1, 2);
+  }
+  if (const char* a = std::getenv("MYDAW_RT_ABORT"); a && *a == '1') std::abort();
+  reporting = false;
+}
+// Resolved on first use; racing threads store the same pointer. No function-local statics here,
+// their guards could block.
+template<class F> F real(F& slot, const char* name){
+  if (!slot) slot = reinterpret_cast<F>(dlsym(RTLD_NEXT, name));
+  return slot;
+}
+} // namespace
+void enter(){ ++depth; }
+void leave(){ --depth; }
+unsigned long violations(){ return count.load(); }
+} // namespace
+using mydaw::rt::violation;
+using mydaw::rt::real;
+extern "C" {
+void* malloc(size_t n){ violation("malloc"); return __libc_malloc(n); }
+void* calloc(size_t n, size_t m){ violation("calloc"); return __libc_calloc(n, m); }
+void* realloc(void* p, size_t n){ violation("realloc"); return __libc_realloc(p, n); }
+void free(void* p){ if (p) violation("free"); __libc_free(p); }
+void* aligned_alloc(size_t a, size_t n){ violation("aligned_alloc"); return __libc_memalign(a, n); }
+void* memalign(size_t a, size_t n){ violation("memalign"); return __libc_memalign(a, n); }
+int posix_memalign(void** out, size_t a, size_t n){
+  violation("posix_memalign");
+  *out = __libc_memalign(a, n);
+  return *out ? 0 : 12; // ENOMEM
+}
+int pthread_mutex_lock(pthread_mutex_t* m){
+  using Fn = int(*)(pthread_mutex_t*); static Fn fn = nullptr; real(fn, "pthread_mutex_lock");
+  violation("pthread_mutex_lock"); return fn(m);
+}
+int pthread_cond_wait(pthread_cond_t* c, pthread_mutex_t* m){
+  using Fn = int(*)(pthread_cond_t*, pthread_mutex_t*); static Fn fn = nullptr; real(fn, "pthread_cond_wait");
+  violation("pthread_cond_wait"); return fn(c, m);
+}
+int pthread_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* t){
+  using Fn = int(*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*); static Fn fn = nullptr; real(fn, "pthread_cond_timedwait");
+  violation("pthread_cond_timedwait"); return fn(c, m, t);
+}
+int sem_wait(sem_t* s){
+  using Fn = int(*)(sem_t*); static Fn fn = nullptr; real(fn, "sem_wait");
+  violation("sem_wait"); return fn(s);
+}
+int nanosleep(const struct timespec* req, struct timespec* rem){
+  using Fn = int(*)(const struct timespec*, struct timespec*); static Fn fn = nullptr; real(fn, "nanosleep");
+  violation("nanosleep"); return fn(req, rem);
+}
+int usleep(useconds_t us){
+  using Fn = int(*)(useconds_t); static Fn fn = nullptr; real(fn, "usleep");
+  violation("usleep"); return fn(us);
+}
+unsigned int sleep(unsigned int s){
+  using Fn = unsigned int(*)(unsigned int); static Fn fn = nullptr; real(fn, "sleep");
+  violation("sleep"); return fn(s);
+}
+int open(const char* path, int flags, ...){
+  using Fn = int(*)(const char*, int, ...); static Fn fn = nullptr; real(fn, "open");
+  mode_t mode = 0;
+  if (flags & (O_CREAT | O_TMPFILE)){ va_list ap; va_start(ap, flags); mode = (mode_t)va_arg(ap, int); va_end(ap); }
+  violation("open"); return fn(path, flags, mode);
+}
+ssize_t read(int fd, void* buf, size_t n){
+  using Fn = ssize_t(*)(int, void*, size_t); static Fn fn = nullptr; real(fn, "read");
+  violation("read"); return fn(fd, buf, n);
+}
+ssize_t write(int fd, const void* buf, size_t n){
+  using Fn = ssize_t(*)(int, const void*, size_t); static Fn fn = nullptr; real(fn, "write");
+  violation("write"); return fn(fd, buf, n);
+}
+}
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+namespace mydaw::rt {
+// Debug aid, built with -DMYDAW_RT_SANITIZER=ON: while a RealtimeScope is open on a thread, heap
+// allocation, mutex and semaphore waits, sleeps and blocking file I/O made on that thread are
+// reported with a stack trace (each distinct trace once). A process that saw violations exits
+// with kViolationExit, so any run of a sanitizer build fails on them; set MYDAW_RT_ABORT=1 to
+// abort at the first one instead. In normal builds the scope compiles to nothing.
+constexpr int kViolationExit = 86;
+#ifdef MYDAW_RT_SANITIZER
+void enter();
+void leave();
+unsigned long violations();
+#else
+inline void enter(){}
+inline void leave(){}
+inline unsigned long violations(){ return 0; }
+#endif
+struct RealtimeScope{
+  RealtimeScope(){ enter(); }
+  ~RealtimeScope(){ leave(); }
+  RealtimeScope(const RealtimeScope&)=delete;
+  RealtimeScope& operator=(const RealtimeScope&)=delete;
+};
+} // namespace
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include "SpscQueue.h"
+namespace mydaw {
+// Publishes immutable snapshots from one control thread to the audio thread, RCU style. At most
+// three are live at once (the audio thread's current one, one pending, one being built), the
+// triple-buffer shape. The audio thread adopts the newest pending snapshot and hands the one it
+// replaces back through a ring; the control thread drops it in collect(), so reference counts
+// never reach zero on the audio thread and it never frees memory.
+template<class T>
+class SnapshotExchange{
+  using Holder = std::shared_ptr<const T>;
+  std::atomic<Holder*> pending_{nullptr};
+  Holder* current_{nullptr};       // audio thread
+  SpscQueue<Holder*> retired_;     // audio thread -> control thread
+public:
+  explicit SnapshotExchange(size_t retireCapacity = 16): retired_(retireCapacity) {}
+  ~SnapshotExchange(){ collect(); delete pending_.load(); delete current_; }
+  SnapshotExchange(const SnapshotExchange&)=delete;
+  SnapshotExchange& operator=(const SnapshotExchange&)=delete;
+  // Control thread. A pending snapshot the audio thread never picked up is dropped right away.
+  void publish(std::shared_ptr<const T> next){
+    collect();
+    delete pending_.exchange(new Holder(std::move(next)), std::memory_order_acq_rel);
+  }
+  void collect(){
+    while (Holder* const* h = retired_.front()){ delete *h; retired_.pop(); }
+  }
+  // Audio thread: the newest published snapshot, or null before the first publish(). Valid
+  // until the next acquire(). Keeps the current one while the retire ring is full.
+  const T* acquire(){
+    if (pending_.load(std::memory_order_relaxed) && retired_.free_slots() > 0){
+      if (Holder* next = pending_.exchange(nullptr, std::memory_order_acq_rel)){
+        if (current_) retired_.push(current_);
+        current_ = next;
+      }
+    }
+    return current_ ? current_->get() : nullptr;
+  }
+};
+} // namespace
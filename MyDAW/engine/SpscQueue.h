@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <cstddef>
+namespace mydaw {
+// Bounded lock-free single-producer/single-consumer ring. Storage is allocated once in the
+// constructor; push/pop never allocate or block. Capacity is rounded up to a power of two.
+template<class T>
+class SpscQueue{
+  std::vector<T> buf_;
+  size_t mask_;
+  alignas(64) std::atomic<size_t> head_{0}; // next slot to write (producer)
+  alignas(64) std::atomic<size_t> tail_{0}; // next slot to read (consumer)
+  static size_t pow2(size_t n){ size_t p=1; while (p<n) p<<=1; return p; }
+public:
+  explicit SpscQueue(size_t capacity): buf_(pow2(capacity < 2 ? 2 : capacity)), mask_(buf_.size()-1) {}
+  size_t capacity() const { return buf_.size(); }
+  // Producer side.
+  size_t free_slots() const { return buf_.size() - (head_.load(std::memory_order_relaxed) - tail_.load(std::memory_order_acquire)); }
+  bool push(const T& v){
+    const size_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) == buf_.size()) return false;
+    buf_[h & mask_] = v;
+    head_.store(h+1, std::memory_order_release);
+    return true;
+  }
+  // Consumer side.
+  const T* front() const {
+    const size_t t = tail_.load(std::memory_order_relaxed);
+    return t == head_.load(std::memory_order_acquire) ? nullptr : &buf_[t & mask_];
+  }
+  void pop(){ tail_.store(tail_.load(std::memory_order_relaxed)+1, std::memory_order_release); }
+};
+} // namespace
@@ -0,0 +1,131 @@
+#include "Tracer.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+namespace mydaw {
+namespace {
+// Ring indices taken by attached threads. The calling thread's index is a plain thread_local,
+// so reading it in record() needs no guard, lock or allocation.
+std::atomic<uint64_t> attachedMask{0};
+thread_local int ringIndex = -1;
+int64_t steady_ns(){ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+void write_json_string(std::FILE* f, const std::string& s){
+  std::fputc('"', f);
+  for (char c : s){ if (c=='"' || c=='\\') std::fputc('\\', f); if ((unsigned char)c >= 0x20) std::fputc(c, f); }
+  std::fputc('"', f);
+}
+} // namespace
+void Tracer::Histogram::add(double v){
+  ++count; sum += v; max = std::max(max, v);
+  ++bins[(size_t)std::clamp((int)(v * kBins), 0, kBins - 1)];
+}
+Tracer::Tracer(size_t eventsPerThread, int maxThreads){
+  for (int i = 0; i < maxThreads; ++i) rings_.push_back(std::make_unique<SpscQueue<Rec>>(eventsPerThread));
+}
+Tracer::~Tracer(){ stop(); }
+// The acquire on taking an index and the release on giving it back order one thread's pushes
+// before the next owner's, so each ring keeps a single producer at a time.
+bool Tracer::attach(){
+  if (ringIndex >= 0) return true;
+  for (uint64_t mask = attachedMask.load(std::memory_order_relaxed); ~mask != 0;){
+    const int i = std::countr_zero(~mask);
+    if (attachedMask.compare_exchange_weak(mask, mask | (uint64_t{1} << i), std::memory_order_acquire, std::memory_order_relaxed)){ ringIndex = i; return true; }
+  }
+  return false;
+}
+void Tracer::detach(){
+  if (ringIndex < 0) return;
+  attachedMask.fetch_and(~(uint64_t{1} << ringIndex), std::memory_order_release);
+  ringIndex = -1;
+}
+uint64_t Tracer::now(){
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return (uint64_t)steady_ns();
+#endif
+}
+bool Tracer::start(const std::string& path, double sampleRate){
+  if (running()) return false;
+  std::FILE* f = nullptr;
+  if (!path.empty() && !(f = std::fopen(path.c_str(), "w"))) return false;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    file_ = f; firstRecord_ = true;
+    if (file_) std::fputs("[\n", file_);
+    loads_.clear(); margin_ = Histogram{};
+  }
+  sr_ = sampleRate;
+  // Calibrate now() against the steady clock; the drain thread keeps refining it.
+  tsc0_ = now(); ns0_ = steady_ns();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ticksPerUs_ = (double)(now() - tsc0_) / ((double)(steady_ns() - ns0_) * 1e-3);
+  run_.store(true);
+  drainer_ = std::thread([this]{ drain_loop(); });
+  return true;
+}
+void Tracer::stop(){
+  if (!running()) return;
+  run_.store(false);
+  drainer_.join();
+  drain_once();
+  std::lock_guard<std::mutex> lk(mu_);
+  if (file_){ std::fputs("\n]\n", file_); std::fclose(file_); file_ = nullptr; }
+}
+void Tracer::setName(int id, std::string name){
+  std::lock_guard<std::mutex> lk(mu_);
+  names_[id] = std::move(name);
+}
+std::string Tracer::name_of(int id) const{
+  if (auto it = names_.find(id); it != names_.end()) return it->second;
+  return id == kBlock ? "callback" : id == kGather ? "gather" : "node " + std::to_string(id);
+}
+std::vector<Tracer::NodeLoad> Tracer::nodeLoads() const{
+  std::lock_guard<std::mutex> lk(mu_);
+  std::vector<NodeLoad> out;
+  for (const auto& [id, h] : loads_) out.push_back(NodeLoad{id, name_of(id), h});
+  std::sort(out.begin(), out.end(), [](const NodeLoad& a, const NodeLoad& b){ return a.id < b.id; });
+  return out;
+}
+Tracer::Histogram Tracer::deadlineMargin() const{
+  std::lock_guard<std::mutex> lk(mu_);
+  return margin_;
+}
+void Tracer::record(int id, uint64_t t0, uint64_t t1, uint32_t frames){
+  if (!run_.load(std::memory_order_relaxed)) return;
+  const int slot = ringIndex;
+  if (slot < 0 || slot >= (int)rings_.size() || !rings_[(size_t)slot]->push(Rec{t0, t1, id, frames})) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+void Tracer::drain_loop(){
+  while (run_.load(std::memory_order_relaxed)){
+    drain_once();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+void Tracer::drain_once(){
+  if (const double us = (double)(steady_ns() - ns0_) * 1e-3; us > 1e5) ticksPerUs_ = (double)(now() - tsc0_) / us;
+  std::lock_guard<std::mutex> lk(mu_);
+  for (int r = 0; r < (int)rings_.size(); ++r){
+    auto& q = *rings_[(size_t)r];
+    while (const Rec* rec = q.front()){
+      const double durUs = (double)(rec->t1 - rec->t0) / ticksPerUs_;
+      const double budgetUs = (double)rec->frames / sr_ * 1e6;
+      if (budgetUs > 0){
+        const double load = durUs / budgetUs;
+        loads_[rec->id].add(load);
+        if (rec->id == kBlock){ margin_.add(1.0 - load); if (load > 1.0) ++margin_.overruns; }
+      }
+      if (file_){
+        std::fputs(firstRecord_ ? "" : ",\n", file_); firstRecord_ = false;
+        std::fputs("{\"name\":", file_); write_json_string(file_, name_of(rec->id));
+        std::fprintf(file_, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frames\":%u}}",
+                     r, (double)(int64_t)(rec->t0 - tsc0_) / ticksPerUs_, durUs, rec->frames);
+      }
+      q.pop();
+    }
+  }
+}
+} // namespace
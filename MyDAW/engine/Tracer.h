@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "SpscQueue.h"
+namespace mydaw {
+// Low-overhead timing trace for the audio path. Real-time threads call record() with raw
+// timestamps from now() (the TSC where available); each thread writes its own lock-free ring,
+// picked by the index it took with attach(). A background thread drains the rings into a Chrome/Perfetto trace JSON
+// file (optional) and into per-node histograms of CPU load, i.e. time spent relative to the
+// real-time length of the audio processed, and of the callback's deadline margin. A full ring
+// drops events rather than block, so it can stay on in production.
+class Tracer{
+public:
+  static constexpr int kBlock = -1;   // a whole audio callback
+  static constexpr int kGather = -2;  // event scheduling for a callback
+  // Load in 5% bins; the last bin also counts everything above. Deadline margin uses the same
+  // bins for the fraction of the budget left; overruns are counted separately.
+  struct Histogram{
+    static constexpr int kBins = 20;
+    std::array<uint64_t,kBins> bins{};
+    uint64_t count{0}, overruns{0};
+    double sum{0}, max{0};
+    double mean() const { return count ? sum / (double)count : 0.0; }
+    void add(double v);
+  };
+  struct NodeLoad{ int id; std::string name; Histogram load; };
+  explicit Tracer(size_t eventsPerThread = 1 << 14, int maxThreads = 16);
+  ~Tracer();
+  Tracer(const Tracer&)=delete;
+  Tracer& operator=(const Tracer&)=delete;
+  // Control thread. An empty path keeps only the histograms.
+  bool start(const std::string& path, double sampleRate);
+  void stop();
+  bool running() const { return run_.load(std::memory_order_relaxed); }
+  void setName(int id, std::string name);
+  std::vector<NodeLoad> nodeLoads() const;
+  Histogram deadlineMargin() const;
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  // A thread that records calls attach() before its first record() and detach() before it
+  // exits, both off the real-time path: the index it takes picks its ring in every tracer, so
+  // record() itself is lock-free. Events of a thread that is not attached, or whose index is
+  // past maxThreads, count as dropped.
+  static bool attach();
+  static void detach();
+  // Real-time threads.
+  static uint64_t now();
+  void record(int id, uint64_t t0, uint64_t t1, uint32_t frames);
+private:
+  struct Rec{ uint64_t t0, t1; int32_t id; uint32_t frames; };
+  std::vector<std::unique_ptr<SpscQueue<Rec>>> rings_; // by attach() index
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> run_{false};
+  double sr_{48000.0};
+  // Drain thread; mu_ guards what the control thread reads.
+  std::thread drainer_;
+  mutable std::mutex mu_;
+  std::unordered_map<int, std::string> names_;
+  std::unordered_map<int, Histogram> loads_;
+  Histogram margin_;
+  std::FILE* file_{nullptr};
+  bool firstRecord_{true};
+  uint64_t tsc0_{0}; int64_t ns0_{0}; double ticksPerUs_{1000.0};
+  std::string name_of(int id) const; // mu_ held
+  void drain_loop();
+  void drain_once();
+};
+} // namespace
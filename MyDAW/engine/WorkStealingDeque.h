@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+namespace mydaw {
+// Bounded Chase-Lev deque of task ids. The owner pushes and pops at the bottom (LIFO, cache
+// warm); other threads steal from the top. Storage is allocated by reset(); push/pop/steal never
+// allocate or block. Capacity must cover the tasks live at once, not the total ever pushed.
+class WorkStealingDeque{
+  std::unique_ptr<std::atomic<int>[]> buf_;
+  int64_t mask_{0};
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+public:
+  static constexpr int kEmpty = -1;
+  void reset(size_t capacity){
+    size_t p = 2; while (p < capacity) p <<= 1;
+    buf_.reset(new std::atomic<int>[p]);
+    mask_ = (int64_t)p - 1;
+    top_.store(0); bottom_.store(0);
+  }
+  // Owner only.
+  void push(int v){
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    buf_[b & mask_].store(v, std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_release);
+  }
+  int pop(){
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b){ bottom_.store(b + 1, std::memory_order_relaxed); return kEmpty; }
+    int v = buf_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b){ // last item: race the thieves for it
+      if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) v = kEmpty;
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return v;
+  }
+  // Any thread.
+  int steal(){
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) return kEmpty;
+    const int v = buf_[t & mask_].load(std::memory_order_relaxed);
+    return top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed) ? v : kEmpty;
+  }
+};
+} // namespace
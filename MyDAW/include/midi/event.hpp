@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include "midi/pattern.hpp"
+namespace mydaw::midi {
+enum class EvType : uint8_t{
+  NoteOn, NoteOff,
+  PitchBend,       // value: -8192..8191
+  PitchRamp,       // value -> value2 over ramp_samples()
+  CC,              // pitch: controller number, value: 0..16383 (7-bit sources scaled by 128)
+  ChannelPressure, // value: 0..16383
+  PolyPressure,    // pitch: note, value: 0..16383
+  NoteExpression   // MPE per-note: pitch: note, vel: ExprDim, value: bend -8192..8191 or 0..16383
+};
+enum class ExprDim : uint8_t{ Pitch, Pressure, Timbre };
+// Packed 16-byte event, four per cache line. gen is the 16-bit bank<<8|pad target id.
+struct Ev{
+  uint32_t sampOff{0};
+  uint16_t gen{0};
+  EvType type{EvType::NoteOn};
+  uint8_t pitch{0};
+  uint8_t vel{0};     // velocity, or ExprDim for NoteExpression
+  uint8_t chan{0};    // source MIDI channel (MPE member channel)
+  int16_t value{0};
+  int16_t value2{0};
+  uint16_t ramp{0};   // PitchRamp length in kRampQuantum-sample units
+  static constexpr uint32_t kRampQuantum = 16;
+  uint32_t ramp_samples() const { return (uint32_t)ramp * kRampQuantum; }
+  static Ev note(EvType type, uint32_t off, GenId gen, uint8_t pitch, uint8_t vel){
+    Ev e; e.sampOff=off; e.gen=(uint16_t)gen; e.type=type; e.pitch=pitch; e.vel=vel; return e;
+  }
+  static Ev bend(uint32_t off, GenId gen, uint8_t pitch, int value){
+    Ev e = note(EvType::PitchBend, off, gen, pitch, 0); e.value=(int16_t)std::clamp(value, -8192, 8191); return e;
+  }
+  static Ev bend_ramp(uint32_t off, GenId gen, uint8_t pitch, int from, int to, uint32_t samples){
+    Ev e = note(EvType::PitchRamp, off, gen, pitch, 0);
+    e.value=(int16_t)std::clamp(from, -8192, 8191); e.value2=(int16_t)std::clamp(to, -8192, 8191);
+    e.ramp=(uint16_t)std::min<uint32_t>((samples + kRampQuantum/2) / kRampQuantum, 0xFFFF);
+    return e;
+  }
+  static Ev control(EvType type, uint32_t off, GenId gen, uint8_t number, int value, uint8_t dim = 0){
+    Ev e = note(type, off, gen, number, dim); e.value=(int16_t)std::clamp(value, -8192, 16383); return e;
+  }
+};
+static_assert(sizeof(Ev) == 16, "Ev must stay packed to 16 bytes");
+// Block order: by sample offset, NoteOff before anything else at the same offset.
+inline bool ev_before(const Ev& a, const Ev& b){
+  if (a.sampOff != b.sampOff) return a.sampOff < b.sampOff;
+  return a.type == EvType::NoteOff && b.type != EvType::NoteOff;
+}
+// Fixed-capacity event storage. Capacity is set once with reserve() (off the audio thread);
+// push() never reallocates and counts dropped events instead.
+class EventBuffer{
+  std::vector<Ev> ev_; size_t n_{0}; uint64_t overflow_{0};
+public:
+  void reserve(size_t cap){ ev_.resize(cap); n_ = std::min(n_, cap); }
+  size_t capacity() const { return ev_.size(); }
+  size_t size() const { return n_; }
+  bool empty() const { return n_==0; }
+  void clear(){ n_=0; }
+  void truncate(size_t n){ n_ = std::min(n_, n); }
+  void count_dropped(uint64_t n){ overflow_ += n; }
+  bool push(const Ev& e){ if (n_==ev_.size()){ ++overflow_; return false; } ev_[n_++]=e; return true; }
+  Ev& operator[](size_t i){ return ev_[i]; }
+  const Ev& operator[](size_t i) const { return ev_[i]; }
+  Ev* begin(){ return ev_.data(); } Ev* end(){ return ev_.data()+n_; }
+  const Ev* begin() const { return ev_.data(); } const Ev* end() const { return ev_.data()+n_; }
+  uint64_t overflow_count() const { return overflow_; }
+  void reset_overflow(){ overflow_=0; }
+};
+// Structure-of-arrays block events for the audio thread: same contract as EventBuffer, but
+// each field is its own column in one allocation, so a scan over offsets or types (sub-block
+// splitting, filtering dense controller data) touches only the bytes it needs. The columns
+// point into store_, so lanes are neither copied nor moved.
+class EventLanes{
+  std::vector<uint8_t> store_;
+  uint32_t* off_{nullptr}; uint16_t* gen_{nullptr}; EvType* type_{nullptr};
+  uint8_t* pitch_{nullptr}; uint8_t* vel_{nullptr}; uint8_t* chan_{nullptr};
+  int16_t* value_{nullptr}; int16_t* value2_{nullptr}; uint16_t* ramp_{nullptr};
+  size_t cap_{0}, n_{0}; uint64_t overflow_{0};
+  template<class T> static T* carve(uint8_t*& p, size_t n){
+    T* r = reinterpret_cast<T*>(p); p += (n*sizeof(T) + 63) & ~size_t(63); return r;
+  }
+public:
+  EventLanes()=default;
+  EventLanes(const EventLanes&)=delete;
+  EventLanes& operator=(const EventLanes&)=delete;
+  void reserve(size_t cap){
+    cap = (cap + 63) & ~size_t(63);
+    store_.assign(cap*sizeof(Ev) + 9*64 + 64, 0);
+    uint8_t* p = store_.data() + ((64 - ((uintptr_t)store_.data() & 63)) & 63);
+    off_=carve<uint32_t>(p,cap); gen_=carve<uint16_t>(p,cap); type_=carve<EvType>(p,cap);
+    pitch_=carve<uint8_t>(p,cap); vel_=carve<uint8_t>(p,cap); chan_=carve<uint8_t>(p,cap);
+    value_=carve<int16_t>(p,cap); value2_=carve<int16_t>(p,cap); ramp_=carve<uint16_t>(p,cap);
+    cap_=cap; n_=0;
+  }
+  size_t capacity() const { return cap_; }
+  size_t size() const { return n_; }
+  bool empty() const { return n_==0; }
+  void clear(){ n_=0; }
+  void count_dropped(uint64_t n){ overflow_ += n; }
+  bool push(const Ev& e){
+    if (n_==cap_){ ++overflow_; return false; }
+    off_[n_]=e.sampOff; gen_[n_]=e.gen; type_[n_]=e.type; pitch_[n_]=e.pitch; vel_[n_]=e.vel;
+    chan_[n_]=e.chan; value_[n_]=e.value; value2_[n_]=e.value2; ramp_[n_]=e.ramp; ++n_;
+    return true;
+  }
+  Ev operator[](size_t i) const {
+    Ev e; e.sampOff=off_[i]; e.gen=gen_[i]; e.type=type_[i]; e.pitch=pitch_[i]; e.vel=vel_[i];
+    e.chan=chan_[i]; e.value=value_[i]; e.value2=value2_[i]; e.ramp=ramp_[i]; return e;
+  }
+  Ev back() const { return (*this)[n_-1]; }
+  const uint32_t* offsets() const { return off_; }
+  const EvType* types() const { return type_; }
+  const uint16_t* gens() const { return gen_; }
+  uint64_t overflow_count() const { return overflow_; }
+  void reset_overflow(){ overflow_=0; }
+};
+} // namespace
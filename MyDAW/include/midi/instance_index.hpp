@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include "midi/timeline.hpp"
+namespace mydaw::midi {
+struct PatternInstance;
+// Static interval index over the loop-aware extents of a set of pattern instances: instances
+// sorted by start with an implicit tree of subtree max-ends, so an overlap query visits
+// O(log n + hits) instances. Built off the audio thread whenever the instance list changes.
+class InstanceIndex{
+  struct Item{ Tick beg, end, lastStart, startTick, loopLen; std::shared_ptr<const PatternTimeline> tl; };
+  std::vector<Item> items_;
+  std::vector<Tick> maxEnd_; // max end over the implicit subtree rooted at each index
+  Tick lastStart_{std::numeric_limits<Tick>::min()};
+  Tick build_max(size_t lo, size_t hi);
+  template<class F> bool visit(Tick qa, Tick qb, F& f, size_t lo, size_t hi) const{
+    if (lo >= hi) return false;
+    const size_t mid = lo + (hi - lo)/2;
+    if (maxEnd_[mid] <= qa) return false;
+    if (visit(qa, qb, f, lo, mid)) return true;
+    const Item& it = items_[mid];
+    if (it.beg >= qb) return false;
+    if (it.end > qa && f(it)) return true;
+    return visit(qa, qb, f, mid + 1, hi);
+  }
+public:
+  InstanceIndex()=default;
+  // Instances without a compiled timeline are compiled here.
+  explicit InstanceIndex(const std::vector<PatternInstance>& instances);
+  size_t size() const { return items_.size(); }
+  // Earliest loop-aware note start strictly after tick, or PatternTimeline::kNever.
+  // Only instances overlapping (tick, horizon) are searched.
+  Tick next_start_after(Tick tick, Tick horizon) const;
+  // True if any note start lies after tick, however far away.
+  bool has_start_after(Tick tick) const { return lastStart_ > tick; }
+  bool any_note_in(Tick startTick, Tick endTick) const;
+};
+} // namespace
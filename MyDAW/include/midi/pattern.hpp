@@ -1,10 +1,14 @@
 #pragma once
+#include <memory_resource>
 #include <vector>
 #include <cstdint>
 #include "midi/timing.hpp"
 namespace mydaw::midi {
 using GenId = uint32_t;
 struct Note{ Tick start{0}; Tick len{0}; uint8_t pitch{60}; uint8_t vel{100}; uint8_t rel{64}; bool slide{false}; int fine{0}; };
-struct ChannelPattern{ GenId gen{0}; std::vector<Note> notes; };
-struct Pattern{ Tick length{kPPQ*4}; std::vector<ChannelPattern> channels; };
+// Containers are pmr so a loader can place whole patterns in an arena (see io::Session); they
+// default to the global heap.
+struct ChannelPattern{ GenId gen{0}; std::pmr::vector<Note> notes; };
+// Bump revision after editing so cached compiled timelines are rebuilt.
+struct Pattern{ Tick length{kPPQ*4}; std::pmr::vector<ChannelPattern> channels; uint64_t revision{0}; };
 } // namespace
@@ -1,26 +1,52 @@
 #pragma once
 #include "midi/pattern.hpp"
 #include "midi/timing.hpp"
+#include "midi/event.hpp"
+#include "midi/timeline.hpp"
+#include "midi/instance_index.hpp"
 #include <vector>
-#include <random>
+#include <memory>
 namespace mydaw::midi {
-enum class EvType{ NoteOn, NoteOff, PitchBend };
-struct Ev{ GenId gen; EvType type; uint32_t sampOff; uint8_t pitch; uint8_t vel; int pb{0}; };
 struct PatternInstance{
   const Pattern* pattern{nullptr}; Tick startTick{0}; Tick loopLengthTicks{0};
   bool enabled{true}; bool muted{false}; float gain{1.0f}; int transpose{0};
+  EventTransform transform{};                      // quantize/swing/humanize, baked into timeline
+  std::shared_ptr<const PatternTimeline> timeline; // filled by Scheduler::compile_timelines
 };
 class Scheduler{
   TimeBase tb_;
+  struct Run{ uint32_t beg, end; };
+  // Audio-thread scratch for gather_realtime, sized by reserve(); see EventBuffer.
+  mutable EventBuffer staging_;
+  mutable std::vector<Run> runs_;
+  mutable std::vector<uint32_t> heap_;
 public:
   explicit Scheduler(TimeBase tb):tb_(tb){}
   void set_timebase(TimeBase tb){ tb_=tb; }
   const TimeBase& get_timebase() const { return tb_; }
+  // Compiles the timeline of every instance, sharing one per (pattern, transform). Timelines that
+  // are still current (same pattern revision and transform) are kept. Allocates; call it off the
+  // audio thread whenever the instance list, a pattern or a transform changes.
+  static void compile_timelines(std::vector<PatternInstance>& instances);
+  void gather(const PatternTimeline& tl, Tick clipStartTick, Tick loopLenTick, int64_t blockSample, uint32_t frames, std::vector<Ev>& out) const;
   void gather(const Pattern& pat, Tick clipStartTick, Tick loopLenTick, int64_t blockSample, uint32_t frames, std::vector<Ev>& out) const;
-  void gather_realtime(const std::vector<PatternInstance>& instances, int64_t blockSample, uint32_t frames, std::vector<Ev>& out) const;
+  // Sizes the realtime scratch: maxEvents per block, maxRuns sorted per-instance streams per block.
+  void reserve(size_t maxEvents, size_t maxRuns);
+  // Gathers every instance into sorted runs and k-way merges them into `out` without allocating.
+  // Events beyond the reserved capacity are dropped and counted in out.overflow_count().
+  // Instances without a compiled timeline (see compile_timelines) are skipped.
+  void gather_realtime(const std::vector<PatternInstance>& instances, int64_t blockSample, uint32_t frames, EventLanes& out) const;
+  // Block-level variants on sample offsets; PatternInstance::transform applies the same
+  // operations once at compile time in musical position.
   void apply_swing(std::vector<Ev>& events, float swingPercent, Tick swingResolution) const;
-  void apply_humanize(std::vector<Ev>& events, float timingVariation, float velocityVariation) const;
+  // Deterministic: each NoteOn's offsets are drawn from (seed, gen, pitch, absolute sample), so
+  // realtime and offline renders agree. blockSample is the absolute position of events[].sampOff 0.
+  void apply_humanize(std::vector<Ev>& events, float timingVariation, float velocityVariation, uint64_t seed = 0, int64_t blockSample = 0) const;
   void quantize_events(std::vector<Ev>& events, Tick quantizeGrid) const;
+  // Loop-aware transport queries. The vector overloads build a temporary InstanceIndex;
+  // keep one per instance list (see AudioEngineRT) to make them logarithmic.
+  Tick get_next_event_tick(const InstanceIndex& index, Tick currentTick) const;
+  bool has_events_in_range(const InstanceIndex& index, Tick startTick, Tick endTick) const;
   Tick get_next_event_tick(const std::vector<PatternInstance>& instances, Tick currentTick) const;
   bool has_events_in_range(const std::vector<PatternInstance>& instances, Tick startTick, Tick endTick) const;
 };
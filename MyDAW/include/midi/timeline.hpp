@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
+#include "midi/event.hpp"
+namespace mydaw::midi {
+// Per-instance note transforms, applied in pattern ticks while compiling: quantize -> swing -> humanize.
+struct EventTransform{
+  Tick quantizeGrid{0};                        // 0: off
+  float swingPercent{50.0f}; Tick swingResolution{kPPQ/2}; // <=50%: off
+  float humanizeTiming{0.0f};                  // fraction of a 64th note
+  float humanizeVelocity{0.0f};                // fraction of full velocity range
+  uint64_t seed{0};                            // humanize keys on (seed, note index): every loop plays the same groove
+  bool operator==(const EventTransform&) const = default;
+};
+// A Pattern flattened into one tick-sorted event array. Every event is stored as
+// (phase in [0,length), wrap) so a note that ends past the pattern length still lands
+// on the right loop iteration: loop k plays it at (k+wrap)*length + phase.
+struct TimelineEv{ Tick phase; uint32_t wrap; GenId gen; EvType type; uint8_t pitch; uint8_t vel; };
+struct TimelineSlide{ Tick phase; uint32_t wrap; Tick len; GenId gen; uint8_t pitch; int fine; };
+class PatternTimeline{
+  Tick length_{0}; uint32_t maxWrap_{0};
+  const Pattern* source_{nullptr}; uint64_t revision_{0}; EventTransform transform_{};
+  std::vector<TimelineEv> events_;
+  std::vector<TimelineSlide> slides_;
+  // One loop iteration in unfolded ticks: sorted note starts and the merged, disjoint note spans.
+  struct Span{ Tick beg, end; };
+  std::vector<Tick> starts_;
+  std::vector<Span> spans_;
+  static Tick floor_div(Tick a, Tick b){ return a>=0 ? a/b : -((-a + b - 1)/b); }
+  static Tick loop_count(Tick len, Tick loopLen){
+    return loopLen > 0 ? (loopLen + len - 1)/len : std::numeric_limits<Tick>::max();
+  }
+public:
+  static constexpr Tick kNever = std::numeric_limits<Tick>::max();
+  static std::shared_ptr<const PatternTimeline> compile(const Pattern& pat, const EventTransform& xf = {});
+  // True if this timeline is current for pat (same object and revision) under xf.
+  bool compiled_from(const Pattern& pat, const EventTransform& xf) const { return source_==&pat && revision_==pat.revision && transform_==xf; }
+  static Tick loops(Tick len, Tick loopLen){ return len > 0 ? loop_count(len, loopLen) : 0; }
+  Tick length() const { return length_; }
+  const std::vector<TimelineEv>& events() const { return events_; }
+  const std::vector<TimelineSlide>& slides() const { return slides_; }
+  bool empty() const { return spans_.empty(); }
+  // Clip-relative extent of all note spans over every loop iteration; kNever when looping forever.
+  Tick first_tick() const { return spans_.empty() ? kNever : spans_.front().beg; }
+  Tick end_tick(Tick loopLen) const;
+  Tick last_start(Tick loopLen) const;
+  // True when some note span (loop-aware, at least one tick long) overlaps [relBeg, relEnd).
+  bool any_note_in(Tick relBeg, Tick relEnd, Tick loopLen) const;
+  // Earliest loop-aware note start strictly after rel, or kNever.
+  Tick next_start_after(Tick rel, Tick loopLen) const;
+  // Calls f(ev, relTick) for every event whose clip-relative tick lies in [relBeg, relEnd),
+  // in tick order. Cost is O(log n + emitted) per loop window the range touches.
+  template<class F> void for_each_event(Tick relBeg, Tick relEnd, Tick loopLen, F&& f) const{ scan(events_, relBeg, relEnd, loopLen, f); }
+  // Same for the start of every slide note.
+  template<class F> void for_each_slide(Tick relBeg, Tick relEnd, Tick loopLen, F&& f) const{ scan(slides_, relBeg, relEnd, loopLen, f); }
+private:
+  template<class T, class F> void scan(const std::vector<T>& v, Tick relBeg, Tick relEnd, Tick loopLen, F& f) const{
+    if (length_<=0 || v.empty() || relEnd<=relBeg) return;
+    const Tick loops = loop_count(length_, loopLen);
+    Tick w = std::max<Tick>(0, floor_div(relBeg, length_));
+    const Tick wLast = std::min<Tick>(floor_div(relEnd - 1, length_), loops == kNever ? loops : loops - 1 + maxWrap_);
+    for (; w <= wLast; ++w){
+      const Tick base = w*length_;
+      const Tick pb = std::max<Tick>(relBeg - base, 0), pe = std::min<Tick>(relEnd - base, length_);
+      auto it = std::lower_bound(v.begin(), v.end(), pb, [](const T& e, Tick t){ return e.phase < t; });
+      for (; it != v.end() && it->phase < pe; ++it){
+        const Tick k = w - (Tick)it->wrap;
+        if (k < 0 || k >= loops) continue;
+        f(*it, base + it->phase);
+      }
+    }
+  }
+};
+} // namespace
@@ -1,21 +1,52 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <memory>
+#include <vector>
 namespace mydaw::midi {
 using Tick = int64_t;
 constexpr Tick kPPQ = 960;
 struct TempoSig{ double bpm{120.0}; int num{4}; int den{4}; };
+// A tempo change at `tick`. With ramp set, tempo moves linearly (in ticks) to the next point's bpm;
+// otherwise it holds until the next point.
+struct TempoPoint{ Tick tick{0}; double bpm{120.0}; bool ramp{false}; };
+// Piecewise constant/linear tempo curve. Cumulative seconds at each segment start are precomputed,
+// so a conversion is a segment lookup plus one closed-form evaluation and never accumulates drift.
+// Lookups take a caller-owned cursor that is checked first, making sequential queries O(1).
+class TempoMap{
+  struct Seg{ Tick tick; double bpm; double slope; double sec; }; // slope: bpm per tick
+  std::vector<Seg> segs_;
+  std::vector<TempoPoint> points_;
+  size_t find_tick(Tick t, size_t& cursor) const;
+  size_t find_sec(double s, size_t& cursor) const;
+public:
+  explicit TempoMap(std::vector<TempoPoint> points);
+  const std::vector<TempoPoint>& points() const { return points_; }
+  double seconds_at(Tick t, size_t& cursor) const;
+  double ticks_at(double seconds, size_t& cursor) const;
+  double bpm_at(Tick t, size_t& cursor) const;
+};
 class TimeBase{
   double sr_{48000.0}; TempoSig t_{};
+  std::shared_ptr<const TempoMap> map_;
+  mutable size_t seg_{0}; // per-owner cursor into map_
 public:
   TimeBase()=default; TimeBase(double sr, TempoSig t):sr_(sr),t_(t){}
-  void set(double sr, TempoSig t){ sr_=sr; t_=t; }
+  void set(double sr, TempoSig t){ sr_=sr; t_=t; map_.reset(); seg_=0; }
+  void set_sample_rate(double sr){ sr_=sr; }
+  void set_tempo_map(std::shared_ptr<const TempoMap> m){ map_=std::move(m); seg_=0; }
+  const std::shared_ptr<const TempoMap>& tempo_map() const { return map_; }
   double sr() const { return sr_; }
   TempoSig tempo() const { return t_; }
+  double bpm_at(Tick t) const { return map_ ? map_->bpm_at(t, seg_) : t_.bpm; }
   inline Tick samples_to_ticks(int64_t samples) const {
+    if (map_) return (Tick)std::floor(map_->ticks_at((double)samples / sr_, seg_) + 0.5);
     const double ticks = (double)samples * (t_.bpm/60.0) * (double)kPPQ / sr_;
     return (Tick)(ticks + 0.5);
   }
   inline int64_t tick_to_samples(Tick ticks) const {
+    if (map_) return (int64_t)std::floor(map_->seconds_at(ticks, seg_) * sr_ + 0.5);
     const double samples = (double)ticks * (60.0/t_.bpm) * (sr_/(double)kPPQ);
     return (int64_t)(samples + 0.5);
   }
@@ -0,0 +1,101 @@
+#include "Json.h"
+#include <cstdlib>
+namespace mydaw::io {
+const JsonValue* JsonValue::get(std::string_view key) const{
+  for (const auto& [k, v] : members) if (k == key) return &v;
+  return nullptr;
+}
+double JsonValue::number_or(std::string_view key, double def) const{
+  const JsonValue* v = get(key);
+  return v && v->type == Type::Number ? v->number : def;
+}
+namespace {
+struct Parser{
+  std::string_view s; size_t i{0}; std::string err;
+  explicit Parser(std::string_view text): s(text) {}
+  bool fail(const char* what){ if (err.empty()) err = std::string(what) + " at offset " + std::to_string(i); return false; }
+  void ws(){ while (i < s.size() && (s[i]==' ' || s[i]=='\n' || s[i]=='\r' || s[i]=='\t')) ++i; }
+  bool lit(std::string_view w){ if (s.substr(i, w.size()) != w) return fail("bad literal"); i += w.size(); return true; }
+  bool string(std::string& out){
+    if (i >= s.size() || s[i] != '"') return fail("expected string");
+    for (++i; i < s.size() && s[i] != '"'; ++i){
+      if (s[i] != '\\'){ out += s[i]; continue; }
+      if (++i >= s.size()) break;
+      switch (s[i]){
+        case 'n': out += '\n'; break;
+        case 't': out += '\t'; break;
+        case 'r': out += '\r'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'u': {
+          if (i + 4 >= s.size()) return fail("bad escape");
+          const unsigned cp = (unsigned)std::strtoul(std::string(s.substr(i+1, 4)).c_str(), nullptr, 16);
+          i += 4;
+          if (cp < 0x80) out += (char)cp;
+          else if (cp < 0x800){ out += (char)(0xC0 | cp>>6); out += (char)(0x80 | (cp & 0x3F)); }
+          else { out += (char)(0xE0 | cp>>12); out += (char)(0x80 | (cp>>6 & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+          break;
+        }
+        default: out += s[i];
+      }
+    }
+    if (i >= s.size()) return fail("unterminated string");
+    ++i;
+    return true;
+  }
+  bool value(JsonValue& v, int depth){
+    if (depth > 256) return fail("nesting too deep");
+    ws();
+    if (i >= s.size()) return fail("unexpected end");
+    switch (s[i]){
+      case '{': {
+        v.type = JsonValue::Type::Object; ++i; ws();
+        if (i < s.size() && s[i] == '}'){ ++i; return true; }
+        for (;;){
+          ws(); std::pair<std::string, JsonValue> m;
+          if (!string(m.first)) return false;
+          ws(); if (i >= s.size() || s[i] != ':') return fail("expected ':'");
+          ++i;
+          if (!value(m.second, depth + 1)) return false;
+          v.members.push_back(std::move(m));
+          ws(); if (i < s.size() && s[i] == ','){ ++i; continue; }
+          if (i < s.size() && s[i] == '}'){ ++i; return true; }
+          return fail("expected ',' or '}'");
+        }
+      }
+      case '[': {
+        v.type = JsonValue::Type::Array; ++i; ws();
+        if (i < s.size() && s[i] == ']'){ ++i; return true; }
+        for (;;){
+          v.items.emplace_back();
+          if (!value(v.items.back(), depth + 1)) return false;
+          ws(); if (i < s.size() && s[i] == ','){ ++i; continue; }
+          if (i < s.size() && s[i] == ']'){ ++i; return true; }
+          return fail("expected ',' or ']'");
+        }
+      }
+      case '"': v.type = JsonValue::Type::String; return string(v.str);
+      case 't': v.type = JsonValue::Type::Bool; v.boolean = true; return lit("true");
+      case 'f': v.type = JsonValue::Type::Bool; return lit("false");
+      case 'n': return lit("null");
+      default: {
+        const std::string num(s.substr(i, std::min<size_t>(64, s.size() - i)));
+        char* end = nullptr;
+        v.number = std::strtod(num.c_str(), &end);
+        if (end == num.c_str()) return fail("unexpected character");
+        v.type = JsonValue::Type::Number; i += (size_t)(end - num.c_str());
+        return true;
+      }
+    }
+  }
+};
+} // namespace
+bool parse_json(std::string_view text, JsonValue& out, std::string& err){
+  Parser p{text};
+  out = JsonValue{};
+  bool ok = p.value(out, 0);
+  if (ok){ p.ws(); if (p.i != text.size()) ok = p.fail("trailing characters"); }
+  err = p.err;
+  return ok;
+}
+} // namespace
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+namespace mydaw::io {
+// Minimal JSON document model for session files.
+struct JsonValue{
+  enum class Type{ Null, Bool, Number, String, Array, Object };
+  Type type{Type::Null};
+  bool boolean{false};
+  double number{0.0};
+  std::string str;
+  std::vector<JsonValue> items;                            // Array
+  std::vector<std::pair<std::string, JsonValue>> members;  // Object, in file order
+  const JsonValue* get(std::string_view key) const;
+  double number_or(std::string_view key, double def) const;
+};
+// Returns false and sets err (with the byte offset) on malformed input.
+bool parse_json(std::string_view text, JsonValue& out, std::string& err);
+} // namespace
@@ -0,0 +1,114 @@
+#include "JsonReader.h"
+#include <charconv>
+#include <cstdlib>
+namespace mydaw::io {
+using Tok = JsonReader::Tok;
+Tok JsonReader::fail(const char* what){
+  if (err_.empty()) err_ = std::string(what) + " at offset " + std::to_string(i_);
+  return Tok::Error;
+}
+bool JsonReader::read_string(){
+  const size_t beg = ++i_;
+  bool escaped = false;
+  while (i_ < s_.size() && s_[i_] != '"'){ if (s_[i_] == '\\'){ escaped = true; ++i_; } ++i_; }
+  if (i_ >= s_.size()){ fail("unterminated string"); return false; }
+  str_ = s_.substr(beg, i_ - beg);
+  ++i_;
+  if (!escaped) return true;
+  scratch_.clear();
+  for (size_t k = 0; k < str_.size(); ++k){
+    if (str_[k] != '\\'){ scratch_ += str_[k]; continue; }
+    switch (str_[++k]){
+      case 'n': scratch_ += '\n'; break;
+      case 't': scratch_ += '\t'; break;
+      case 'r': scratch_ += '\r'; break;
+      case 'b': scratch_ += '\b'; break;
+      case 'f': scratch_ += '\f'; break;
+      case 'u': {
+        unsigned cp = 0;
+        std::from_chars(str_.data() + k + 1, str_.data() + std::min(str_.size(), k + 5), cp, 16);
+        k += 4;
+        if (cp < 0x80) scratch_ += (char)cp;
+        else if (cp < 0x800){ scratch_ += (char)(0xC0 | cp>>6); scratch_ += (char)(0x80 | (cp & 0x3F)); }
+        else { scratch_ += (char)(0xE0 | cp>>12); scratch_ += (char)(0x80 | (cp>>6 & 0x3F)); scratch_ += (char)(0x80 | (cp & 0x3F)); }
+        break;
+      }
+      default: scratch_ += str_[k];
+    }
+  }
+  str_ = scratch_;
+  return true;
+}
+Tok JsonReader::next(){
+  if (failed()) return Tok::Error;
+  ws();
+  if (rootDone_) return i_ < s_.size() ? fail("trailing characters") : Tok::End;
+  if (i_ >= s_.size()) return fail("unexpected end");
+  if (expectSep_){
+    const char close = stack_.back() == '{' ? '}' : ']';
+    if (s_[i_] == ','){
+      ++i_; ws(); expectSep_ = false;
+      if (i_ < s_.size() && (s_[i_] == '}' || s_[i_] == ']')) return fail("trailing comma");
+    } else if (s_[i_] != close) return fail("expected ','");
+  }
+  const char c = s_[i_];
+  if (c == '}' || c == ']'){
+    if (!expectKey_ && !expectSep_ && !stack_.empty() && stack_.back() == '{') return fail("expected value");
+    if (stack_.empty() || stack_.back() != (c == '}' ? '{' : '[')) return fail("mismatched bracket");
+    stack_.pop_back(); ++i_;
+    value_done();
+    return c == '}' ? Tok::EndObject : Tok::EndArray;
+  }
+  if (expectKey_){
+    if (c != '"') return fail("expected key");
+    if (!read_string()) return Tok::Error;
+    ws();
+    if (i_ >= s_.size() || s_[i_] != ':') return fail("expected ':'");
+    ++i_;
+    expectKey_ = false;
+    return Tok::Key;
+  }
+  switch (c){
+    case '{': stack_.push_back('{'); ++i_; expectSep_ = false; expectKey_ = true; return Tok::BeginObject;
+    case '[': stack_.push_back('['); ++i_; expectSep_ = false; expectKey_ = false; return Tok::BeginArray;
+    case '"': if (!read_string()) return Tok::Error; value_done(); return Tok::String;
+    case 't': case 'f': case 'n': {
+      const std::string_view w = c == 't' ? "true" : c == 'f' ? "false" : "null";
+      if (s_.substr(i_, w.size()) != w) return fail("bad literal");
+      i_ += w.size(); bool_ = c == 't';
+      value_done();
+      return c == 'n' ? Tok::Null : Tok::Bool;
+    }
+    default: {
+      const char* beg = s_.data() + i_;
+      const char* end = s_.data() + s_.size();
+      if (*beg == '+') return fail("unexpected character");
+      auto [p, ec] = std::from_chars(beg, end, num_);
+      if (ec != std::errc{}) return fail("unexpected character");
+      i_ += (size_t)(p - beg);
+      value_done();
+      return Tok::Number;
+    }
+  }
+}
+bool JsonReader::skip_container(){
+  for (size_t depth = 1; depth > 0;){
+    switch (next()){
+      case Tok::BeginObject: case Tok::BeginArray: ++depth; break;
+      case Tok::EndObject: case Tok::EndArray: --depth; break;
+      case Tok::Error: case Tok::End: return false;
+      default: break;
+    }
+  }
+  return true;
+}
+std::string_view JsonReader::skip_value(){
+  ws();
+  if (expectSep_ && i_ < s_.size() && s_[i_] == ','){ ++i_; ws(); expectSep_ = false; }
+  const size_t beg = i_;
+  const Tok t = next();
+  if ((t == Tok::BeginObject || t == Tok::BeginArray) && !skip_container()) return {};
+  if (t == Tok::Error || t == Tok::End || t == Tok::EndObject || t == Tok::EndArray) return {};
+  return s_.substr(beg, i_ - beg);
+}
+} // namespace
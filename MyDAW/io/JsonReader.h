@@ -0,0 +1,42 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+namespace mydaw::io {
+// Streaming (pull) JSON tokenizer over an in-memory document. Nothing is materialized: strings
+// and keys are views into the text (decoded into a scratch buffer only when they contain
+// escapes), and skip_value() hands back the raw text of a whole subtree so it can be parsed
+// later, e.g. on first use.
+class JsonReader{
+public:
+  enum class Tok{ BeginObject, EndObject, BeginArray, EndArray, Key, String, Number, Bool, Null, End, Error };
+  explicit JsonReader(std::string_view text): s_(text) {}
+  Tok next();
+  // Valid after Key/String, Number and Bool respectively.
+  std::string_view str() const { return str_; }
+  double number() const { return num_; }
+  bool boolean() const { return bool_; }
+  // Consumes the next value (after a Key, or in place of an array element) and returns its text.
+  std::string_view skip_value();
+  // Consumes the rest of the container whose Begin token was just returned.
+  bool skip_container();
+  bool failed() const { return !err_.empty(); }
+  const std::string& error() const { return err_; }
+private:
+  std::string_view s_;
+  size_t i_{0};
+  std::vector<char> stack_;     // '{' or '[' per open container
+  bool expectSep_{false};       // a value just ended inside a container
+  bool expectKey_{false};       // next token in this object is a key
+  bool rootDone_{false};
+  std::string_view str_;
+  std::string scratch_;
+  double num_{0};
+  bool bool_{false};
+  std::string err_;
+  Tok fail(const char* what);
+  void ws(){ while (i_ < s_.size() && (s_[i_]==' ' || s_[i_]=='\n' || s_[i_]=='\r' || s_[i_]=='\t')) ++i_; }
+  bool read_string();
+  void value_done(){ expectSep_ = !stack_.empty(); expectKey_ = expectSep_ && stack_.back() == '{'; rootDone_ = stack_.empty(); }
+};
+} // namespace
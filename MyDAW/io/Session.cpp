@@ -0,0 +1,233 @@
+#include "Session.h"
+#include "JsonReader.h"
+#include <algorithm>
+#include <fstream>
+namespace mydaw::io {
+using Tok = JsonReader::Tok;
+namespace {
+bool expect(JsonReader& r, Tok t, std::string& err, const char* what){
+  if (r.next() == t) return true;
+  err = r.failed() ? r.error() : std::string("expected ") + what;
+  return false;
+}
+// An element or member loop stopped at t; only the matching close ends it cleanly.
+bool closed(const JsonReader& r, Tok t, Tok close, std::string& err, const char* what){
+  if (t == close) return true;
+  err = r.failed() ? r.error() : std::string("expected ") + what;
+  return false;
+}
+bool read_number(JsonReader& r, double& out, std::string& err){
+  if (!expect(r, Tok::Number, err, "a number")) return false;
+  out = r.number();
+  return true;
+}
+} // namespace
+std::string_view Session::keep(std::string_view s){
+  char* p = static_cast<char*>(arena_.allocate(s.size() ? s.size() : 1, 1));
+  std::copy(s.begin(), s.end(), p);
+  return {p, s.size()};
+}
+bool Session::parse_track(JsonReader& r, std::string& err){
+  const int track = (int)trackNames.size();
+  trackNames.push_back({});
+  if (!expect(r, Tok::BeginObject, err, "a track object")) return false;
+  Tok t;
+  while ((t = r.next()) == Tok::Key){
+    const std::string_view key = r.str();
+    if (key == "name"){
+      if (!expect(r, Tok::String, err, "a track name")) return false;
+      trackNames[(size_t)track] = keep(r.str());
+    } else if (key == "clips"){
+      if (!expect(r, Tok::BeginArray, err, "a clip array")) return false;
+      Tok c;
+      while ((c = r.next()) == Tok::BeginObject){
+        Clip clip{-1, 0, 0, track};
+        Tok k;
+        while ((k = r.next()) == Tok::Key){
+          const std::string_view field = r.str();
+          double v = 0;
+          if (field == "pattern"){ if (!read_number(r, v, err)) return false; clip.id = (int)v; }
+          else if (field == "start"){ if (!read_number(r, v, err)) return false; clip.start = (long long)v; }
+          else if (field == "len"){ if (!read_number(r, v, err)) return false; clip.len = (long long)v; }
+          else if (r.skip_value().empty()){ err = r.error(); return false; }
+        }
+        if (!closed(r, k, Tok::EndObject, err, "a clip field")) return false;
+        playlist.clips.push_back(clip);
+      }
+      if (!closed(r, c, Tok::EndArray, err, "a clip object")) return false;
+    } else if (key == "plugins"){
+      if (!expect(r, Tok::BeginArray, err, "a plugin array")) return false;
+      Tok c;
+      while ((c = r.next()) == Tok::BeginObject){
+        PluginRecord plug{track, {}, {}};
+        Tok k;
+        while ((k = r.next()) == Tok::Key){
+          const std::string_view field = r.str();
+          if (field == "type"){ if (!expect(r, Tok::String, err, "a plugin type")) return false; plug.type = keep(r.str()); }
+          else if (field == "state"){ if ((plug.state = r.skip_value()).empty()){ err = r.error(); return false; } }
+          else if (r.skip_value().empty()){ err = r.error(); return false; }
+        }
+        if (!closed(r, k, Tok::EndObject, err, "a plugin field")) return false;
+        plugins.push_back(plug);
+      }
+      if (!closed(r, c, Tok::EndArray, err, "a plugin object")) return false;
+    } else if (r.skip_value().empty()){ err = r.error(); return false; }
+  }
+  return closed(r, t, Tok::EndObject, err, "a track field");
+}
+bool Session::parse_pads(JsonReader& r, std::string& err){
+  if (!expect(r, Tok::BeginArray, err, "a pad array")) return false;
+  Tok p;
+  while ((p = r.next()) == Tok::BeginObject){
+    PadRecord pad{0, {}, false};
+    Tok k;
+    while ((k = r.next()) == Tok::Key){
+      const std::string_view field = r.str();
+      double v = 0;
+      if (field == "gen"){ if (!read_number(r, v, err)) return false; pad.gen = (uint32_t)v; }
+      else if (field == "file"){ if (!expect(r, Tok::String, err, "a pad file")) return false; pad.file = keep(r.str()); }
+      else if (field == "gated"){ if (!expect(r, Tok::Bool, err, "true or false")) return false; pad.gated = r.boolean(); }
+      else if (r.skip_value().empty()){ err = r.error(); return false; }
+    }
+    if (!closed(r, k, Tok::EndObject, err, "a pad field")) return false;
+    if (pad.gen == 0 || pad.gen > 0xFFFF || pad.file.empty()){ err = "a pad needs a gen in 1..65535 and a file"; return false; }
+    pads.push_back(pad);
+  }
+  return closed(r, p, Tok::EndArray, err, "a pad object");
+}
+bool Session::parse(std::string& err){
+  JsonReader r(text_);
+  if (!expect(r, Tok::BeginObject, err, "a session object")) return false;
+  Tok t;
+  while ((t = r.next()) == Tok::Key){
+    const std::string_view key = r.str();
+    double v = 0;
+    if (key == "sr"){ if (!read_number(r, sr, err)) return false; }
+    else if (key == "block"){ if (!read_number(r, v, err)) return false; block = (int)v; }
+    else if (key == "bpm"){ if (!read_number(r, bpm, err)) return false; }
+    else if (key == "seconds"){ if (!read_number(r, seconds, err)) return false; }
+    else if (key == "patterns"){
+      if (!expect(r, Tok::BeginArray, err, "a pattern array")) return false;
+      Tok p;
+      while ((p = r.next()) == Tok::BeginObject){
+        PatternRecord rec{(int)patterns_.size(), midi::kPPQ*4, {}, nullptr};
+        Tok k;
+        while ((k = r.next()) == Tok::Key){
+          const std::string_view field = r.str();
+          if (field == "id"){ if (!read_number(r, v, err)) return false; rec.id = (int)v; }
+          else if (field == "length"){ if (!read_number(r, v, err)) return false; rec.length = (midi::Tick)v; }
+          else if (field == "channels"){ if ((rec.channels = r.skip_value()).empty()){ err = r.error(); return false; } }
+          else if (r.skip_value().empty()){ err = r.error(); return false; }
+        }
+        if (!closed(r, k, Tok::EndObject, err, "a pattern field")) return false;
+        byId_[rec.id] = patterns_.size();
+        patterns_.push_back(rec);
+      }
+      if (!closed(r, p, Tok::EndArray, err, "a pattern object")) return false;
+    } else if (key == "pads"){
+      if (!parse_pads(r, err)) return false;
+    } else if (key == "tracks"){
+      if (!expect(r, Tok::BeginArray, err, "a track array")) return false;
+      for (;;){
+        const std::string_view track = r.skip_value();
+        if (track.empty()) break;
+        JsonReader tr(track);
+        if (!parse_track(tr, err)) return false;
+      }
+      if (r.failed()){ err = r.error(); return false; }
+    } else if (r.skip_value().empty()){ err = r.error(); return false; }
+  }
+  if (!closed(r, t, Tok::EndObject, err, "a session field")) return false;
+  if (r.next() != Tok::End){ err = r.failed() ? r.error() : "trailing data"; return false; }
+  if (sr <= 0 || block <= 0){ err = "sr and block must be positive"; return false; }
+  return true;
+}
+midi::Pattern* Session::decode(const PatternRecord& rec, std::string& err) const{
+  std::pmr::polymorphic_allocator<> alloc(&arena_);
+  midi::Pattern pat{rec.length, std::pmr::vector<midi::ChannelPattern>(&arena_), 0};
+  JsonReader r(rec.channels);
+  auto fail = [&](const char* what) -> midi::Pattern* {
+    err = "pattern " + std::to_string(rec.id) + ": " + (r.failed() ? r.error() : std::string(what));
+    return nullptr;
+  };
+  if (!rec.channels.empty()){
+    if (r.next() != Tok::BeginArray) return fail("channels must be an array");
+    Tok c;
+    while ((c = r.next()) == Tok::BeginObject){
+      midi::ChannelPattern ch{0, std::pmr::vector<midi::Note>(&arena_)};
+      Tok k;
+      while ((k = r.next()) == Tok::Key){
+        const std::string_view field = r.str();
+        if (field == "gen"){ if (r.next() != Tok::Number) return fail("gen must be a number"); ch.gen = (midi::GenId)r.number(); }
+        else if (field == "notes"){
+          if (r.next() != Tok::BeginArray) return fail("notes must be an array");
+          Tok n;
+          while ((n = r.next()) == Tok::BeginArray){
+            double v[5]; int count = 0;
+            Tok x;
+            while ((x = r.next()) == Tok::Number) if (count++ < 5) v[count - 1] = r.number();
+            if (x != Tok::EndArray || count < 4 || count > 5) return fail("note must be [start, len, pitch, vel] or [start, len, pitch, vel, slide]");
+            midi::Note note;
+            note.start = (midi::Tick)v[0]; note.len = (midi::Tick)v[1];
+            note.pitch = (uint8_t)std::clamp(v[2], 0.0, 127.0);
+            note.vel = (uint8_t)std::clamp(v[3], 1.0, 127.0);
+            if (count == 5 && v[4] != 0){ note.slide = true; note.fine = (int)std::clamp(v[4], -128.0, 127.0); }
+            ch.notes.push_back(note);
+          }
+          if (n != Tok::EndArray) return fail("note must be [start, len, pitch, vel] or [start, len, pitch, vel, slide]");
+        }
+        else if (r.skip_value().empty()) return fail("bad channel field");
+      }
+      if (k != Tok::EndObject) return fail("expected a channel field");
+      pat.channels.push_back(std::move(ch));
+    }
+    if (c != Tok::EndArray) return fail("expected a channel object");
+  }
+  return alloc.new_object<midi::Pattern>(std::move(pat));
+}
+const midi::Pattern* Session::pattern(int id) const{
+  auto it = byId_.find(id);
+  if (it == byId_.end()) return nullptr;
+  PatternRecord& rec = patterns_[it->second];
+  std::string err;
+  if (!rec.decoded) rec.decoded = decode(rec, err);
+  return rec.decoded;
+}
+size_t Session::decodedPatterns() const{
+  return (size_t)std::count_if(patterns_.begin(), patterns_.end(), [](const PatternRecord& p){ return p.decoded != nullptr; });
+}
+bool Session::registry(arrange::PatternRegistry& reg, std::string& err) const{
+  reg = arrange::PatternRegistry{};
+  for (const auto& c : playlist.clips){
+    if (reg.byId.count(c.id)) continue;
+    auto it = byId_.find(c.id);
+    if (it == byId_.end()) continue; // a clip of an unknown pattern plays nothing
+    PatternRecord& rec = patterns_[it->second];
+    if (!rec.decoded && !(rec.decoded = decode(rec, err))) return false;
+    reg.byId[c.id] = rec.decoded;
+  }
+  return true;
+}
+bool Session::pluginState(size_t plugin, JsonValue& out, std::string& err) const{
+  const std::string_view state = plugins[plugin].state;
+  if (state.empty()){ out = JsonValue{}; return true; }
+  return parse_json(state, out, err);
+}
+midi::Tick Session::end_tick() const{
+  midi::Tick end = 0;
+  for (const auto& c : playlist.clips) end = std::max<midi::Tick>(end, c.start + c.len);
+  return end;
+}
+std::unique_ptr<Session> load_session(const std::string& path, std::string& err){
+  std::ifstream f(path, std::ios::binary | std::ios::ate);
+  if (!f){ err = "cannot open " + path; return nullptr; }
+  auto s = std::make_unique<Session>();
+  const size_t slash = path.find_last_of('/');
+  s->dir = slash == std::string::npos ? "." : path.substr(0, slash ? slash : 1);
+  s->text_.resize((size_t)f.tellg());
+  f.seekg(0);
+  if (!f.read(s->text_.data(), (std::streamsize)s->text_.size())){ err = "cannot read " + path; return nullptr; }
+  if (!s->parse(err)){ err = path + ": " + err; return nullptr; }
+  return s;
+}
+} // namespace
@@ -0,0 +1,65 @@
+#pragma once
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "arrange/Playlist.h"
+#include "arrange/TimelineBridge.h"
+#include "midi/pattern.hpp"
+#include "Json.h"
+namespace mydaw::io {
+class JsonReader;
+// A session file (JSON, ticks at midi::kPPQ). Everything except sr/block/tracks is optional:
+//   { "sr": 48000, "block": 64, "bpm": 120, "seconds": 8,
+//     "patterns": [ { "id": 1, "length": 3840,
+//                     "channels": [ { "gen": 257, "notes": [ [start, len, pitch, vel], ... ] } ] } ],
+//     "pads": [ { "gen": 257, "file": "kick.wav", "gated": false } ],
+//     "tracks": [ { "name": "Drums", "clips": [ { "pattern": 1, "start": 0, "len": 3840 } ],
+//                   "plugins": [ { "type": "momentum_delay", "state": { ... } } ] } ] }
+// The file is read with a streaming tokenizer into a model that lives in one arena. Pattern
+// bodies and plugin state stay as raw JSON slices of the file text until first used. A pad's
+// gen is bank<<8|pad, as the pad sampler maps it; relative files are next to the session. A
+// note's optional fifth number slides its pad's pitch over the note (±128 = ±2 semitones).
+class Session{
+public:
+  struct PatternRecord{ int id; mydaw::midi::Tick length; std::string_view channels; mydaw::midi::Pattern* decoded; };
+  struct PluginRecord{ int track; std::string_view type; std::string_view state; };
+  struct PadRecord{ uint32_t gen; std::string_view file; bool gated; };
+  double sr{48000.0};
+  int block{64};
+  double bpm{120.0};
+  double seconds{0.0};                     // 0: until the last clip ends
+private:
+  std::string text_;                       // the file; records point into it
+  mutable std::pmr::monotonic_buffer_resource arena_;
+public:
+  Playlist playlist{std::pmr::vector<Clip>(&arena_)}; // Clip::id is the pattern id
+  std::pmr::vector<std::string_view> trackNames{&arena_};
+  std::pmr::vector<PluginRecord> plugins{&arena_};
+  std::pmr::vector<PadRecord> pads{&arena_};
+  std::string dir;                         // the session file's directory, for relative paths
+  Session()=default;
+  Session(const Session&)=delete;
+  Session& operator=(const Session&)=delete;
+  // Patterns decode on first use (null for unknown ids or malformed bodies). Not thread-safe.
+  const mydaw::midi::Pattern* pattern(int id) const;
+  const std::pmr::vector<PatternRecord>& patternRecords() const { return patterns_; }
+  size_t decodedPatterns() const;
+  // Decodes only the patterns that clips reference; false with err set if one is malformed.
+  bool registry(mydaw::arrange::PatternRegistry& out, std::string& err) const;
+  bool pluginState(size_t plugin, JsonValue& out, std::string& err) const;
+  mydaw::midi::Tick end_tick() const;
+private:
+  mutable std::pmr::vector<PatternRecord> patterns_{&arena_};
+  std::pmr::unordered_map<int, size_t> byId_{&arena_};
+  std::string_view keep(std::string_view s);
+  bool parse(std::string& err);
+  bool parse_track(JsonReader& r, std::string& err);
+  bool parse_pads(JsonReader& r, std::string& err);
+  mydaw::midi::Pattern* decode(const PatternRecord& rec, std::string& err) const;
+  friend std::unique_ptr<Session> load_session(const std::string& path, std::string& err);
+};
+// Null with err set when the file cannot be read or is malformed.
+std::unique_ptr<Session> load_session(const std::string& path, std::string& err);
+} // namespace
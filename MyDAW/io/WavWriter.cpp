@@ -0,0 +1,35 @@
+#include "WavWriter.h"
+namespace mydaw::io {
+namespace {
+void put16(std::FILE* f, uint16_t v){ std::fputc(v & 0xFF, f); std::fputc(v >> 8, f); }
+void put32(std::FILE* f, uint32_t v){ put16(f, (uint16_t)(v & 0xFFFF)); put16(f, (uint16_t)(v >> 16)); }
+} // namespace
+bool WavWriter::open(const std::string& path, int sampleRate, int channels){
+  close();
+  if (!(f_ = std::fopen(path.c_str(), "wb"))) return false;
+  channels_ = channels; frames_ = 0;
+  std::fwrite("RIFF", 1, 4, f_); put32(f_, 0); std::fwrite("WAVE", 1, 4, f_);
+  std::fwrite("fmt ", 1, 4, f_); put32(f_, 16);
+  put16(f_, 3); // IEEE float
+  put16(f_, (uint16_t)channels); put32(f_, (uint32_t)sampleRate);
+  put32(f_, (uint32_t)(sampleRate * channels * 4)); put16(f_, (uint16_t)(channels * 4)); put16(f_, 32);
+  std::fwrite("data", 1, 4, f_); put32(f_, 0);
+  return !std::ferror(f_);
+}
+bool WavWriter::write(const float* interleaved, uint32_t frames){
+  if (!f_) return false;
+  const size_t n = (size_t)frames * (size_t)channels_;
+  if (std::fwrite(interleaved, sizeof(float), n, f_) != n) return false; // little-endian hosts
+  frames_ += frames;
+  return true;
+}
+bool WavWriter::close(){
+  if (!f_) return true;
+  const uint64_t bytes = frames_ * (uint64_t)channels_ * 4;
+  std::fseek(f_, 4, SEEK_SET); put32(f_, (uint32_t)(36 + bytes));
+  std::fseek(f_, 40, SEEK_SET); put32(f_, (uint32_t)bytes);
+  const bool ok = !std::ferror(f_);
+  std::fclose(f_); f_ = nullptr;
+  return ok;
+}
+} // namespace
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+namespace mydaw::io {
+// Streams interleaved 32-bit float frames to a WAVE file; sizes are patched in close().
+class WavWriter{
+  std::FILE* f_{nullptr};
+  int channels_{2};
+  uint64_t frames_{0};
+public:
+  WavWriter()=default;
+  ~WavWriter(){ close(); }
+  WavWriter(const WavWriter&)=delete;
+  WavWriter& operator=(const WavWriter&)=delete;
+  bool open(const std::string& path, int sampleRate, int channels);
+  bool write(const float* interleaved, uint32_t frames);
+  bool close();
+  uint64_t frames() const { return frames_; }
+};
+} // namespace
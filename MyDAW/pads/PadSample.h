@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "sample/SamplePool.h"
+namespace mydaw::pads {
+// Audio a pad plays: planar float channels at their own sample rate, held in the process-wide
+// SamplePool so pads and instances loading the same audio share one copy. Each channel is
+// followed by one zero guard frame, so interpolating readers may touch frame frames().
+// Gated samples fade out on note-off; the rest play through as one-shots.
+class PadSample{
+  sample::SampleRef audio_;
+  bool gated_{false};
+public:
+  PadSample(sample::SampleRef audio, bool gated = false): audio_(std::move(audio)), gated_(gated) {}
+  PadSample(const std::vector<std::vector<float>>& channels, double sr, bool gated = false)
+    : PadSample(sample::SamplePool::shared().intern(channels, sr), gated) {}
+  int channels() const { return audio_->channels(); }
+  uint32_t frames() const { return (uint32_t)audio_->frames(); }
+  double sampleRate() const { return audio_->sampleRate(); }
+  bool gated() const { return gated_; }
+  const float* channel(int c) const { return audio_->channel(c); }
+  const sample::SampleRef& audio() const { return audio_; }
+};
+} // namespace
@@ -0,0 +1,133 @@
+#include "PadSampler.h"
+#include <algorithm>
+#include <cmath>
+namespace mydaw::pads {
+void PadSampler::set_sample(uint8_t bank, uint8_t pad, std::shared_ptr<const PadSample> sample){
+  auto next = std::make_shared<PadMap>(*padsCtl_);
+  const uint16_t key = (uint16_t)((bank << 8) | pad);
+  if (sample) next->pads[key] = std::move(sample); else next->pads.erase(key);
+  padsCtl_ = std::move(next);
+  padsLive_.publish(padsCtl_);
+}
+void PadSampler::prepare(double sr, int block){
+  (void)block;
+  sr_ = sr;
+  dsp::warm_resampler();
+  const size_t n = (size_t)maxVoices_;
+  vSample_.assign(n, nullptr); vKey_.assign(n, 0);
+  vFrame_.assign(n, 0); vFrac_.assign(n, 0.0f);
+  vGain_.assign(n, 0.0f); vEnv_.assign(n, 0.0f); vEnvStep_.assign(n, 0.0f);
+  vPrev_.assign(n, -1); vNext_.assign(n, -1);
+  free_.resize(n);
+  for (size_t v = 0; v < n; ++v) free_[v] = (int32_t)(n - 1 - v);
+  oldest_ = newest_ = -1; active_ = 0;
+}
+void PadSampler::refresh(){
+  const PadMap* m = padsLive_.acquire();
+  if (m == pads_) return;
+  pads_ = m;
+  if (!m) return;
+  // The previous map may be freed from now on: drop voices whose sample it alone owned.
+  for (int32_t v = oldest_; v >= 0;){
+    const int32_t next = vNext_[(size_t)v];
+    auto it = m->pads.find(vKey_[(size_t)v]);
+    if (it == m->pads.end() || it->second.get() != vSample_[(size_t)v]) release_voice(v);
+    v = next;
+  }
+}
+int32_t PadSampler::alloc_voice(){
+  int32_t v;
+  if (!free_.empty()){ v = free_.back(); free_.pop_back(); ++active_; }
+  else {
+    if (oldest_ < 0) return -1; // no voices: prepare() has not run
+    v = oldest_; ++stolen_;
+    oldest_ = vNext_[(size_t)v];
+    if (oldest_ >= 0) vPrev_[(size_t)oldest_] = -1; else newest_ = -1;
+  }
+  vPrev_[(size_t)v] = newest_; vNext_[(size_t)v] = -1;
+  if (newest_ >= 0) vNext_[(size_t)newest_] = v; else oldest_ = v;
+  newest_ = v;
+  return v;
+}
+void PadSampler::release_voice(int32_t v){
+  const int32_t p = vPrev_[(size_t)v], n = vNext_[(size_t)v];
+  if (p >= 0) vNext_[(size_t)p] = n; else oldest_ = n;
+  if (n >= 0) vPrev_[(size_t)n] = p; else newest_ = p;
+  vSample_[(size_t)v] = nullptr;
+  free_.push_back(v); // capacity is the pool size, so this never allocates
+  --active_;
+}
+void PadSampler::note_on(PadHit hit){
+  refresh();
+  if (!pads_) return;
+  const uint16_t key = (uint16_t)((hit.bank << 8) | hit.pad);
+  auto it = pads_->pads.find(key);
+  if (it == pads_->pads.end() || !it->second || it->second->frames() == 0) return;
+  const int32_t v = alloc_voice();
+  if (v < 0) return;
+  const size_t i = (size_t)v;
+  vSample_[i] = it->second.get(); vKey_[i] = key;
+  vFrame_[i] = 0; vFrac_[i] = 0.0f;
+  vGain_[i] = (float)hit.vel / 127.0f;
+  vEnv_[i] = 1.0f; vEnvStep_[i] = 0.0f;
+}
+void PadSampler::note_off(PadHit hit){
+  refresh();
+  const uint16_t key = (uint16_t)((hit.bank << 8) | hit.pad);
+  const float step = -1.0f / std::max(1.0f, kReleaseMs * 0.001f * (float)sr_);
+  for (int32_t v = oldest_; v >= 0; v = vNext_[(size_t)v]){
+    const size_t i = (size_t)v;
+    if (vKey_[i] == key && vSample_[i]->gated() && vEnvStep_[i] == 0.0f) vEnvStep_[i] = step;
+  }
+}
+void PadSampler::process(const AudioBlock& blk){
+  refresh();
+  const dsp::Interp q = interp_.load(std::memory_order_relaxed);
+  for (int c = 0; c < blk.channels; ++c) std::fill_n(blk.out[c], blk.frames, 0.0f);
+  for (int32_t v = oldest_; v >= 0;){
+    const size_t i = (size_t)v;
+    const int32_t next = vNext_[i];
+    const PadSample& s = *vSample_[i];
+    const uint8_t bank = (uint8_t)(vKey_[i] >> 8), pad = (uint8_t)(vKey_[i] & 0xFF);
+    const BendRamp* bend = anyBend_ ? find_bend(bank, pad) : nullptr;
+    // A sliding pad renders in kBendStep pieces, each at the bend of its midpoint.
+    const int piece = bend && bend->remaining ? kBendStep : blk.frames;
+    bool ended = false;
+    for (int at = 0; at < blk.frames && !ended; at += piece){
+      const int want = std::min(piece, blk.frames - at);
+      const float semis = bend ? bend_value(*bend, (uint32_t)(at + want / 2)) * (2.0f / 8192.0f) : 0.0f;
+      const float rate = (float)(s.sampleRate() / sr_) * (semis != 0.0f ? std::exp2(semis / 12.0f) : 1.0f);
+      // Frames this piece can render: bounded by the sample's end and by a finishing release.
+      const float left = (float)(s.frames() - vFrame_[i]) - vFrac_[i];
+      int n = std::min(want, (int)std::ceil(left / rate));
+      if (vEnvStep_[i] < 0.0f) n = std::min(n, (int)std::ceil(vEnv_[i] / -vEnvStep_[i]));
+      n = std::max(n, 0);
+      const float g = vGain_[i] * vEnv_[i], gStep = vGain_[i] * vEnvStep_[i];
+      const bool direct = rate == 1.0f && vFrac_[i] == 0.0f;
+      for (int c = 0; c < blk.channels; ++c){
+        const float* src = s.channel(std::min(c, s.channels() - 1));
+        if (direct) dsp::mix_ramp(blk.out[c] + at, src + vFrame_[i], g, gStep, n);
+        else dsp::mix_resample(q, blk.out[c] + at, src, s.frames(), (double)vFrame_[i] + vFrac_[i], rate, g, gStep, n);
+      }
+      const float pos = vFrac_[i] + rate * (float)n;
+      vFrame_[i] += (uint32_t)pos; vFrac_[i] = pos - std::floor(pos);
+      vEnv_[i] += vEnvStep_[i] * (float)n;
+      ended = n < want || vFrame_[i] >= s.frames() || vEnv_[i] <= 0.0f;
+    }
+    if (ended) release_voice(v);
+    v = next;
+  }
+  bool anyBend = false;
+  for (auto& b : bends_){
+    if (!b.used) continue;
+    if (b.remaining){
+      const uint32_t n = b.remaining < (uint32_t)blk.frames ? b.remaining : (uint32_t)blk.frames;
+      b.remaining -= n;
+      b.value = b.remaining ? b.value + b.step*(float)n : b.target;
+    }
+    if (b.remaining==0 && b.target==0.0f) b.used = false; // a slide back to 0 frees the slot
+    anyBend |= b.used;
+  }
+  anyBend_ = anyBend;
+}
+} // namespace
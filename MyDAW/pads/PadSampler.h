@@ -1,15 +1,104 @@
 #pragma once
 #include <cstdint>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "../engine/Node.h"
+#include "../engine/SnapshotExchange.h"
+#include "../dsp/Resampler.h"
+#include "PadSample.h"
 namespace mydaw::pads {
 struct PadHit{ uint8_t bank, pad, vel; };
+// Per-pad bend state: a constant bend, or a linear ramp toward `target` interpolated per sample.
+struct BendRamp{ uint8_t bank{0}, pad{0}; bool used{false}; float value{0}, step{0}, target{0}; uint32_t remaining{0}; };
+// Which sample each bank<<8|pad plays; published to the audio thread as a snapshot.
+struct PadMap{ std::unordered_map<uint16_t, std::shared_ptr<const PadSample>> pads; };
+// Polyphonic sample player behind every scheduled pad event. Voices live in a structure of
+// arrays sized once by prepare(); a free stack plus a start-ordered list make note_on O(1),
+// stealing the oldest voice when all are busy. Bends (±8192 = ±2 semitones) set each voice's
+// playback rate: once per block when constant, every kBendStep frames while a ramp slides.
+// Voices off the output rate are resampled at the chosen interpolation quality.
 class PadSampler : public Node{
+  static constexpr int kMaxBends = 64;
+  static constexpr int kBendStep = 16; // frames rendered at one rate while a pad's bend slides
+  std::array<BendRamp,kMaxBends> bends_{};
+  bool anyBend_{false};
+  // The slot holding (bank,pad)'s bend, else a free one; null when every slot holds another
+  // pad's bend. Slots free up only once their bend is back at 0.
+  BendRamp* bend_slot(uint8_t bank, uint8_t pad){
+    BendRamp* idle = nullptr;
+    for (auto& b : bends_){
+      if (b.used && b.bank==bank && b.pad==pad) return &b;
+      if (!idle && !b.used) idle = &b;
+    }
+    return idle;
+  }
+  void set_bend(const BendRamp& r){
+    BendRamp* b = bend_slot(r.bank, r.pad);
+    if (r.remaining==0 && r.target==0.0f){ if (b) b->used = false; return; }
+    if (!b) return; // kMaxBends pads already bent: this one stays straight
+    *b = r;
+    anyBend_ = true;
+  }
+  const BendRamp* find_bend(uint8_t bank, uint8_t pad) const {
+    for (const auto& b : bends_) if (b.used && b.bank==bank && b.pad==pad) return &b;
+    return nullptr;
+  }
+  // Control thread.
+  std::shared_ptr<const PadMap> padsCtl_{std::make_shared<const PadMap>()};
+  SnapshotExchange<PadMap> padsLive_;
+  int maxVoices_{kDefaultVoices};
+  std::atomic<dsp::Interp> interp_{kDefaultInterp};
+  // Audio thread. Voice v's fields are column entries [v]; prev/next chain active voices
+  // oldest first.
+  const PadMap* pads_{nullptr};
+  double sr_{48000.0};
+  std::vector<const PadSample*> vSample_;
+  std::vector<uint16_t> vKey_;
+  std::vector<uint32_t> vFrame_;       // integer read position
+  std::vector<float> vFrac_;           // fractional read position
+  std::vector<float> vGain_, vEnv_, vEnvStep_;
+  std::vector<int32_t> vPrev_, vNext_;
+  std::vector<int32_t> free_;
+  int32_t oldest_{-1}, newest_{-1};
+  int active_{0};
+  uint64_t stolen_{0};
+  void refresh();
+  int32_t alloc_voice();
+  void release_voice(int32_t v);
 public:
-  void prepare(double sr,int block) override {(void)sr;(void)block;}
-  void process(const AudioBlock&) override {}
+  static constexpr int kDefaultVoices = 256;
+  static constexpr float kReleaseMs = 5.0f;
+  static constexpr dsp::Interp kDefaultInterp = dsp::Interp::Cubic;
+  void prepare(double sr,int block) override;
+  void process(const AudioBlock& blk) override;
   int latencySamples() const override { return 0; }
-  void note_on(PadHit){ }
-  void note_off(PadHit){ }
-  void pitch_bend(uint8_t,uint8_t,int){ }
+  // Control thread: what (bank,pad) plays from the next block on; null clears it. Voices still
+  // playing a replaced sample stop. collect() frees maps the audio thread has let go of.
+  void set_sample(uint8_t bank, uint8_t pad, std::shared_ptr<const PadSample> sample);
+  void collect(){ padsLive_.collect(); }
+  // Interpolation for pitched voices, from the next block on.
+  void set_interpolation(dsp::Interp q){ interp_.store(q, std::memory_order_relaxed); }
+  dsp::Interp interpolation() const { return interp_.load(std::memory_order_relaxed); }
+  // Voice pool size, applied by the next prepare().
+  void set_max_voices(int n){ maxVoices_ = n > 0 ? n : 1; }
+  int max_voices() const { return (int)vKey_.size(); }
+  int active_voices() const { return active_; }
+  uint64_t stolen_voices() const { return stolen_; }
+  void note_on(PadHit hit);
+  void note_off(PadHit hit);
+  void pitch_bend(uint8_t bank,uint8_t pad,int pb){ set_bend(BendRamp{bank,pad,true,(float)pb,0,(float)pb,0}); }
+  void pitch_ramp(uint8_t bank,uint8_t pad,int from,int to,uint32_t samples){
+    const float step = samples ? (float)(to - from) / (float)samples : 0.0f;
+    set_bend(BendRamp{bank,pad,true,samples ? (float)from : (float)to,step,(float)to,samples});
+  }
+  // Bend of (bank,pad) at sample i of the current block, before process() advances it.
+  float bend_at(uint8_t bank,uint8_t pad,uint32_t i) const {
+    const BendRamp* b = find_bend(bank,pad);
+    return b ? bend_value(*b, i) : 0.0f;
+  }
+  static float bend_value(const BendRamp& b, uint32_t i){ return i < b.remaining ? b.value + b.step*(float)i : b.target; }
 };
 } // namespace
@@ -1,4 +1,5 @@
 #include "../include/AnalyticaVaccine.h"
+#include <algorithm>
 
 namespace mydaw::plugins::analytica_vaccine {
 
@@ -10,10 +11,10 @@ void AnalyticaVaccine::prepare(double sampleRate, int maxBlockSize) {
 }
 
 void AnalyticaVaccine::process(const AudioBlock& block) {
-    for (int ch = 0; ch < 2; ++ch) {
-        for (int i = 0; i < block.frames; ++i) {
-            block.out[ch][i] = block.in[ch][i];
-        }
+    // Pass-through: nothing to do when the graph runs us in place
+    if (block.inPlace) return;
+    for (int ch = 0; ch < block.channels; ++ch) {
+        std::copy_n(block.in[ch], block.frames, block.out[ch]);
     }
 }
 
@@ -1,5 +1,9 @@
 #pragma once
 #include "engine/Node.h"
+#include "sample/SampleLoader.h"
+#include <array>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -22,7 +26,13 @@ public:
     void process(const AudioBlock& block) override;
     int latencySamples() const override { return 0; }
 
-    void loadSample(int slotIndex, const std::string& filepath);
+    // Memory-maps a WAV or AIFF file for streaming; false if it cannot be opened.
+    bool loadSample(int slotIndex, const std::string& filepath);
+    // Non-blocking variant for loading a kit: the file opens on a SampleLoader worker in
+    // deadline order, and the slot takes it (and done(ok) runs) in the next
+    // SampleLoader::shared().poll(). A later load or clear of the slot wins.
+    void loadSampleAsync(int slotIndex, const std::string& filepath,
+                         sample::Deadline deadline = sample::kNow, std::function<void(bool)> done = {});
     void clearSlot(int slotIndex);
     
     void setGrainParams(const GrainParams& params);
@@ -35,11 +45,13 @@ private:
     double sampleRate_ = 44100.0;
     
     struct Sample {
-        std::vector<float> data;
+        std::shared_ptr<const sample::StreamedSample> source;
         bool loaded = false;
     };
     
     std::vector<Sample> samples_;
+    std::array<uint32_t, MAX_SAMPLES> slotLoads_{};  // per slot, bumped by every load and clear
+    std::shared_ptr<char> alive_ = std::make_shared<char>(); // loader callbacks skip a deleted instance
     GrainParams grainParams_;
     float variationIntensity_ = 0.5f;
 };
@@ -1,4 +1,5 @@
 #include "../include/FractalRemixer.h"
+#include <algorithm>
 
 namespace mydaw::plugins::fractal_remixer {
 
@@ -13,23 +14,44 @@ void FractalRemixer::prepare(double sampleRate, int maxBlockSize) {
 }
 
 void FractalRemixer::process(const AudioBlock& block) {
-    for (int ch = 0; ch < 2; ++ch) {
-        for (int i = 0; i < block.frames; ++i) {
-            block.out[ch][i] = 0.0f;
-        }
+    for (int ch = 0; ch < block.channels; ++ch) {
+        std::fill_n(block.out[ch], block.frames, 0.0f);
     }
 }
 
-void FractalRemixer::loadSample(int slotIndex, const std::string& filepath) {
-    if (slotIndex >= 0 && slotIndex < MAX_SAMPLES) {
-        // Placeholder for sample loading
-        samples_[slotIndex].loaded = true;
+bool FractalRemixer::loadSample(int slotIndex, const std::string& filepath) {
+    if (slotIndex < 0 || slotIndex >= MAX_SAMPLES) return false;
+    std::string err;
+    auto source = sample::SamplePool::shared().stream(filepath, err); // shared with other instances
+    if (!source) return false;
+    ++slotLoads_[slotIndex]; // supersedes any load still in flight
+    samples_[slotIndex].source = std::move(source);
+    samples_[slotIndex].loaded = true;
+    return true;
+}
+
+void FractalRemixer::loadSampleAsync(int slotIndex, const std::string& filepath, sample::Deadline deadline, std::function<void(bool)> done) {
+    if (slotIndex < 0 || slotIndex >= MAX_SAMPLES) {
+        if (done) done(false);
+        return;
     }
+    const uint32_t serial = ++slotLoads_[slotIndex];
+    std::weak_ptr<char> alive = alive_;
+    sample::SampleLoader::shared().stream(filepath, deadline,
+        [this, alive, slotIndex, serial, done = std::move(done)](std::shared_ptr<const sample::StreamedSample> source, const std::string&) {
+            const bool ok = source && !alive.expired() && slotLoads_[slotIndex] == serial;
+            if (ok) {
+                samples_[slotIndex].source = std::move(source);
+                samples_[slotIndex].loaded = true;
+            }
+            if (done) done(ok);
+        });
 }
 
 void FractalRemixer::clearSlot(int slotIndex) {
     if (slotIndex >= 0 && slotIndex < MAX_SAMPLES) {
-        samples_[slotIndex].data.clear();
+        ++slotLoads_[slotIndex];
+        samples_[slotIndex].source.reset();
         samples_[slotIndex].loaded = false;
     }
 }
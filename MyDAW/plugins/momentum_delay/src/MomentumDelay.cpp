@@ -1,4 +1,6 @@
 #include "../include/MomentumDelay.h"
+#include <algorithm>
+#include <cstddef>
 
 namespace mydaw::plugins::momentum_delay {
 
@@ -12,9 +14,10 @@ void MomentumDelay::prepare(double sampleRate, int maxBlockSize) {
 }
 
 void MomentumDelay::process(const AudioBlock& block) {
-    for (int i = 0; i < block.frames; ++i) {
-        block.out[0][i] = block.in[0][i];
-        block.out[1][i] = block.in[1][i];
+    // Pass-through: nothing to do when the graph runs us in place
+    if (block.inPlace) return;
+    for (int ch = 0; ch < block.channels; ++ch) {
+        std::copy_n(block.in[ch], block.frames, block.out[ch]);
     }
 }
 
@@ -1,8 +1,14 @@
 #pragma once
 #include "engine/Node.h"
+#include "engine/SnapshotExchange.h"
+#include "dsp/Resampler.h"
+#include "sample/SampleLoader.h"
 #include <vector>
 #include <array>
+#include <functional>
 #include <memory>
+#include <string>
+#include <cstdint>
 
 namespace mydaw::plugins::nostalgia_tron {
 
@@ -23,10 +29,28 @@ struct TapeEffects {
     float tapeHiss = 0.2f;         // 0.0 to 1.0
 };
 
+// One recording and the range of notes it plays, repitched from its root note.
+// The recording is decoded to 16-bit in the background the first time a note needs it;
+// stereo recordings play folded down to mono, like the rest of the instrument.
+struct Keyzone {
+    int lowNote = 0;
+    int highNote = 127;
+    int rootNote = 60;
+    std::shared_ptr<sample::LazySample> sample;
+};
+
+// Keyzones of one sample set, published to the audio thread as an immutable snapshot
+struct Keymap {
+    std::vector<Keyzone> zones;
+    std::array<int16_t, 128> zoneForNote; // index into zones, -1 where no zone plays
+    Keymap() { zoneForNote.fill(-1); }
+};
+
 // Voice state for polyphony management
 struct Voice {
     int noteNumber = -1;
-    float phase = 0.0f;
+    int zone = -1;                 // into the current Keymap
+    double phase = 0.0;            // position in the zone's recording, in its frames
     float velocity = 0.0f;
     float adsrEnv = 0.0f;
     bool active = false;
@@ -57,6 +81,18 @@ public:
     void setRelease(float timeMs);          // 0 to 5000ms
     void setSampleSet(SampleSet set);
     void setTapeEffects(const TapeEffects& effects);
+    void setInterpolation(dsp::Interp quality);  // repitching quality (default: 16-tap sinc)
+
+    // Directory holding strings/, choir/, flute/ and cellos/. Each holds one WAV file per
+    // keyzone, named by the zone's root MIDI note ("48.wav", or "48_C3.wav"); a zone reaches
+    // halfway to its neighbours' roots. Sets are only scanned here and in setSampleSet; audio
+    // is loaded per zone on first use, and shared with other instances through the SamplePool.
+    void setSampleLibrary(const std::string& directory);
+    static std::shared_ptr<Keymap> scanSampleSet(const std::string& directory);
+    // Loads every zone of the current set in the background, behind whatever played notes need,
+    // so the first notes of a session do not wait. done(ok) runs from SampleLoader::shared().poll()
+    // once all zones are in; ok is false if any failed to load.
+    void preloadSampleSet(sample::Deadline deadline = sample::kWhenIdle, std::function<void(bool)> done = {});
 
 private:
     static constexpr int MAX_VOICES = 3;
@@ -73,9 +109,14 @@ private:
     
     // Sample playback
     SampleSet currentSampleSet_ = SampleSet::STRINGS;
-    std::vector<std::vector<float>> sampleData_; // Pre-loaded samples
+    std::string libraryPath_;
+    std::shared_ptr<const Keymap> keymapCtl_;
+    SnapshotExchange<Keymap> keymapLive_;
+    const Keymap* keymap_ = nullptr;             // audio thread
     void loadSampleSet(SampleSet set);
-    float getSample(int noteNumber, float phase);
+    void refreshKeymap();
+    dsp::Interp interp_ = dsp::Interp::Sinc16;
+    std::vector<float> scratch_;                 // one voice's resampled block
     
     // Controls
     float volume_ = 0.8f;
@@ -91,6 +132,8 @@ private:
     float flutterPhase_ = 0.0f;
     float getTapePitchModulation(float time);
     float getTapeHiss();
+    static constexpr uint64_t kHissSeed = 0x7a9e5u;
+    uint64_t hissCounter_ = 0;
     
     // ADSR envelope
     float processADSR(Voice& voice, bool noteHeld);
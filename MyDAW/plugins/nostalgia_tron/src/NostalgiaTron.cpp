@@ -1,7 +1,9 @@
 #include "../include/NostalgiaTron.h"
 #include <cmath>
 #include <algorithm>
-#include <random>
+#include <cstdlib>
+#include <filesystem>
+#include "dsp/CounterRng.h"
 
 namespace mydaw::plugins::nostalgia_tron {
 
@@ -11,6 +13,9 @@ NostalgiaTron::NostalgiaTron() {
         voice.active = false;
         voice.noteNumber = -1;
     }
+    
+    // Map the default sample set; its zones load when played
+    loadSampleSet(currentSampleSet_);
 }
 
 NostalgiaTron::~NostalgiaTron() = default;
@@ -19,53 +24,80 @@ void NostalgiaTron::prepare(double sampleRate, int maxBlockSize) {
     sampleRate_ = sampleRate;
     maxBlockSize_ = maxBlockSize;
     updateEnvelopeRates();
-    
-    // Load default sample set
-    loadSampleSet(currentSampleSet_);
+    scratch_.assign(static_cast<size_t>(std::max(maxBlockSize, 1)), 0.0f);
+    dsp::warm_resampler();
 }
 
 void NostalgiaTron::process(const AudioBlock& block) {
     // Zero output buffers
-    for (int ch = 0; ch < 2; ++ch) {
-        for (int i = 0; i < block.frames; ++i) {
-            block.out[ch][i] = 0.0f;
-        }
+    for (int ch = 0; ch < block.channels; ++ch) {
+        std::fill_n(block.out[ch], block.frames, 0.0f);
     }
     
+    refreshKeymap();
+    
+    // Tape modulation moves once per block, so the pitch is worked out once per voice
+    const float pitchMod = getTapePitchModulation(0.0f) + pitchBend_;
+    
     // Process each active voice
     for (int v = 0; v < MAX_VOICES; ++v) {
         Voice& voice = voices_[v];
         if (!voice.active) continue;
         
-        for (int i = 0; i < block.frames; ++i) {
-            // Get tape pitch modulation
-            float time = static_cast<float>(i) / static_cast<float>(sampleRate_);
-            float pitchMod = getTapePitchModulation(time) + pitchBend_;
-            
-            // Calculate sample playback rate with modulation
-            float rate = std::pow(2.0f, pitchMod / 12.0f);
-            voice.phase += rate / sampleRate_;
-            
-            // Get sample value
-            float sample = getSample(voice.noteNumber, voice.phase);
-            
-            // Apply ADSR envelope
-            float env = processADSR(voice, true);
-            sample *= env * voice.velocity * volume_;
-            
-            // Apply tone filter
-            sample = applyToneFilter(sample, filterStates_[v]);
+        // A voice whose zone is still loading starts once the recording is in, and is dropped
+        // if the recording cannot be loaded
+        const Keyzone& zone = keymap_->zones[voice.zone];
+        const sample::SampleData* recording = zone.sample->get();
+        if (!recording) {
+            if (zone.sample->failed()) stopVoice(v);
+            continue;
+        }
+        const int channels = std::min(recording->channels(), 2);
+        const float channelGain = 1.0f / static_cast<float>(channels);
+        
+        // Repitch from the zone's root note, and from its recording rate to ours
+        const double step = std::pow(2.0, (voice.noteNumber - zone.rootNote + pitchMod) / 12.0)
+                          * recording->sampleRate() / sampleRate_;
+        // Tape replay stops at the end of the tape, or of the recording if it is shorter
+        const double tapeEnd = std::min(static_cast<double>(recording->frames()),
+                                        SAMPLE_DURATION_SECONDS * recording->sampleRate());
+        
+        const int frames = static_cast<int>(std::clamp(std::ceil((tapeEnd - voice.phase) / step), 0.0, static_cast<double>(block.frames)));
+        const int chunk = static_cast<int>(scratch_.size());
+        for (int start = 0; chunk > 0 && start < frames; start += chunk) {
+            const int n = std::min(frames - start, chunk);
             
-            // Add tape hiss
-            sample += getTapeHiss() * 0.01f;
+            // Resample the 16-bit recording into the scratch buffer, summing a stereo pair to mono
+            std::fill_n(scratch_.data(), n, 0.0f);
+            double next = voice.phase;
+            for (int c = 0; c < channels; ++c) {
+                next = dsp::mix_resample(interp_, scratch_.data(), recording->channel16(c), static_cast<int64_t>(recording->frames()),
+                                         voice.phase, static_cast<float>(step), channelGain, 0.0f, n);
+            }
+            voice.phase = next;
             
-            // Output to both channels (stereo)
-            block.out[0][i] += sample;
-            block.out[1][i] += sample;
+            for (int i = 0; i < n; ++i) {
+                float sample = scratch_[i];
+                
+                // Apply ADSR envelope
+                float env = processADSR(voice, true);
+                sample *= env * voice.velocity * volume_;
+                
+                // Apply tone filter
+                sample = applyToneFilter(sample, filterStates_[v]);
+                
+                // Add tape hiss
+                sample += getTapeHiss() * 0.01f;
+                
+                // Same signal on every channel
+                for (int ch = 0; ch < block.channels; ++ch) {
+                    block.out[ch][start + i] += sample;
+                }
+            }
         }
         
-        // Stop voice if phase exceeds sample duration
-        if (voice.phase >= SAMPLE_DURATION_SECONDS * sampleRate_) {
+        // Stop voice once it has played the whole recording
+        if (voice.phase >= tapeEnd) {
             stopVoice(v);
         }
     }
@@ -76,6 +108,12 @@ void NostalgiaTron::process(const AudioBlock& block) {
 }
 
 void NostalgiaTron::noteOn(int noteNumber, float velocity) {
+    refreshKeymap();
+    if (noteNumber < 0 || noteNumber > 127 || keymap_->zoneForNote[noteNumber] < 0) return;
+    const int zone = keymap_->zoneForNote[noteNumber];
+    if (keymap_->zones[zone].sample->failed()) return; // nothing to play
+    keymap_->zones[zone].sample->request(); // first use loads the zone in the background
+    
     int voiceIndex = findFreeVoice();
     if (voiceIndex == -1) {
         voiceIndex = findOldestVoice();
@@ -83,8 +121,9 @@ void NostalgiaTron::noteOn(int noteNumber, float velocity) {
     
     Voice& voice = voices_[voiceIndex];
     voice.noteNumber = noteNumber;
+    voice.zone = zone;
     voice.velocity = velocity;
-    voice.phase = 0.0f;
+    voice.phase = 0.0;
     voice.adsrEnv = 0.0f;
     voice.active = true;
     voice.startTime = static_cast<uint64_t>(wowPhase_ * 1000.0f); // Simple timestamp
@@ -130,10 +169,19 @@ void NostalgiaTron::setSampleSet(SampleSet set) {
     loadSampleSet(set);
 }
 
+void NostalgiaTron::setSampleLibrary(const std::string& directory) {
+    libraryPath_ = directory;
+    loadSampleSet(currentSampleSet_);
+}
+
 void NostalgiaTron::setTapeEffects(const TapeEffects& effects) {
     tapeEffects_ = effects;
 }
 
+void NostalgiaTron::setInterpolation(dsp::Interp quality) {
+    interp_ = quality;
+}
+
 int NostalgiaTron::findFreeVoice() {
     for (int i = 0; i < MAX_VOICES; ++i) {
         if (!voices_[i].active) {
@@ -163,41 +211,72 @@ void NostalgiaTron::stopVoice(int voiceIndex) {
 }
 
 void NostalgiaTron::loadSampleSet(SampleSet set) {
-    // Placeholder: In real implementation, load samples from disk
-    // For now, just reserve space
-    sampleData_.clear();
-    sampleData_.resize(128); // One sample per MIDI note
-    
-    for (auto& sample : sampleData_) {
-        sample.resize(static_cast<size_t>(SAMPLE_DURATION_SECONDS * sampleRate_));
-        // Fill with silence or placeholder sine wave
-        for (size_t i = 0; i < sample.size(); ++i) {
-            sample[i] = 0.0f;
-        }
+    // Only the directory is read here: each zone's recording loads when first played, and
+    // the previous set's audio is freed off the audio thread once nothing plays it
+    static constexpr const char* kSetDirectories[] = { "strings", "choir", "flute", "cellos" };
+    auto keymap = libraryPath_.empty()
+        ? std::make_shared<Keymap>()
+        : scanSampleSet(libraryPath_ + "/" + kSetDirectories[static_cast<int>(set)]);
+    keymapCtl_ = std::move(keymap);
+    keymapLive_.publish(keymapCtl_);
+}
+
+void NostalgiaTron::preloadSampleSet(sample::Deadline deadline, std::function<void(bool)> done) {
+    const auto& zones = keymapCtl_->zones;
+    if (zones.empty()) {
+        if (done) done(true);
+        return;
+    }
+    // Completions all arrive in poll() on one thread, so the tally needs no atomics
+    struct Tally { size_t remaining; bool ok; std::function<void(bool)> done; };
+    auto tally = std::make_shared<Tally>(Tally{zones.size(), true, std::move(done)});
+    for (const auto& zone : zones) {
+        sample::SampleLoader::shared().prefetch(zone.sample, deadline, [tally](const sample::LazySample& s) {
+            tally->ok = tally->ok && !s.failed();
+            if (--tally->remaining == 0 && tally->done) tally->done(tally->ok);
+        });
     }
 }
 
-float NostalgiaTron::getSample(int noteNumber, float phase) {
-    if (noteNumber < 0 || noteNumber >= static_cast<int>(sampleData_.size())) {
-        return 0.0f;
+std::shared_ptr<Keymap> NostalgiaTron::scanSampleSet(const std::string& directory) {
+    auto keymap = std::make_shared<Keymap>();
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+        const auto& path = entry.path();
+        if (!entry.is_regular_file(ec) || path.extension() != ".wav") continue;
+        // The file name starts with the zone's root note
+        const std::string stem = path.stem().string();
+        char* end = nullptr;
+        const long root = std::strtol(stem.c_str(), &end, 10);
+        if (end == stem.c_str() || root < 0 || root > 127) continue;
+        Keyzone zone;
+        zone.rootNote = static_cast<int>(root);
+        zone.sample = sample::SampleLoader::shared().make(path.string());
+        keymap->zones.push_back(std::move(zone));
     }
+    auto& zones = keymap->zones;
+    std::sort(zones.begin(), zones.end(), [](const Keyzone& a, const Keyzone& b) { return a.rootNote < b.rootNote; });
+    zones.erase(std::unique(zones.begin(), zones.end(), [](const Keyzone& a, const Keyzone& b) { return a.rootNote == b.rootNote; }), zones.end());
     
-    const auto& sample = sampleData_[noteNumber];
-    if (sample.empty()) {
-        return 0.0f;
+    // Each zone reaches halfway to its neighbours' roots
+    for (size_t z = 0; z < zones.size(); ++z) {
+        zones[z].lowNote = z == 0 ? 0 : zones[z - 1].highNote + 1;
+        zones[z].highNote = z + 1 == zones.size() ? 127 : (zones[z].rootNote + zones[z + 1].rootNote) / 2;
+        for (int note = zones[z].lowNote; note <= zones[z].highNote; ++note) {
+            keymap->zoneForNote[note] = static_cast<int16_t>(z);
+        }
     }
-    
-    // Simple linear interpolation
-    float index = phase * sampleRate_;
-    int idx0 = static_cast<int>(index);
-    int idx1 = idx0 + 1;
-    
-    if (idx0 >= static_cast<int>(sample.size()) - 1) {
-        return 0.0f;
+    return keymap;
+}
+
+void NostalgiaTron::refreshKeymap() {
+    const Keymap* next = keymapLive_.acquire();
+    if (next == keymap_) return;
+    // Voices index the previous keymap, which may be freed from here on
+    for (int v = 0; v < MAX_VOICES; ++v) {
+        if (voices_[v].active) stopVoice(v);
     }
-    
-    float frac = index - static_cast<float>(idx0);
-    return sample[idx0] * (1.0f - frac) + sample[idx1] * frac;
+    keymap_ = next;
 }
 
 float NostalgiaTron::getTapePitchModulation(float time) {
@@ -207,11 +286,8 @@ float NostalgiaTron::getTapePitchModulation(float time) {
 }
 
 float NostalgiaTron::getTapeHiss() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
-    
-    return dis(gen) * tapeEffects_.tapeHiss;
+    // Counter-based noise: no shared static state, no locking or allocation on first use
+    return dsp::CounterRng::bipolar(dsp::CounterRng::hash(kHissSeed, hissCounter_++)) * tapeEffects_.tapeHiss;
 }
 
 float NostalgiaTron::processADSR(Voice& voice, bool noteHeld) {
@@ -43,9 +43,10 @@ void Quantum80::process(const AudioBlock& block) {
         // Apply effects
         mixed = processEffects(mixed);
         
-        // Output to both channels
-        block.out[0][i] = mixed;
-        block.out[1][i] = mixed;
+        // Same signal on every channel
+        for (int ch = 0; ch < block.channels; ++ch) {
+            block.out[ch][i] = mixed;
+        }
     }
 }
 
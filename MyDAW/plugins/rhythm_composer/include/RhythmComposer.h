@@ -1,14 +1,20 @@
 #pragma once
 #include "engine/Node.h"
+#include "engine/SnapshotExchange.h"
+#include "engine/SpscQueue.h"
+#include "dsp/Resampler.h"
+#include "sample/SampleLoader.h"
+#include <functional>
 #include <vector>
 #include <array>
+#include <memory>
 #include <string>
+#include <cstdint>
 
 namespace mydaw::plugins::rhythm_composer {
 
-// Pad configuration
+// Pad configuration (the pad's sample itself is streamed, see RhythmComposer::PadSamples)
 struct PadConfig {
-    std::vector<float> sample;
     float tuning = 0.0f;        // -12 to +12 semitones
     float decay = 1.0f;         // 0.0 to 1.0
     float filterCutoff = 1.0f;  // 0.0 to 1.0
@@ -43,8 +49,14 @@ public:
     void process(const AudioBlock& block) override;
     int latencySamples() const override { return 0; }
 
-    // Sample management
-    void loadSample(int padIndex, const std::string& filepath);
+    // Sample management: WAV and AIFF files are memory-mapped and streamed from disk, only a
+    // short head of each is kept in RAM. Returns false if the file cannot be opened.
+    bool loadSample(int padIndex, const std::string& filepath);
+    // The same without blocking, for opening kits: the file opens on a SampleLoader worker,
+    // ahead of loads with later deadlines, and the pad switches to it from the next
+    // SampleLoader::shared().poll(), which also calls done(ok). A later load or clear wins.
+    void loadSampleAsync(int padIndex, const std::string& filepath,
+                         sample::Deadline deadline = sample::kNow, std::function<void(bool)> done = {});
     void clearPad(int padIndex);
     
     // Pad controls
@@ -54,8 +66,12 @@ public:
     void setPadPan(int padIndex, float pan);
     void setPadDrive(int padIndex, float drive);
     
-    // Manual trigger
-    void triggerPad(int padIndex, float velocity);
+    // Interpolation for tuned pads and samples recorded at another rate (default: 16-tap sinc)
+    void setInterpolation(dsp::Interp quality);
+    
+    // Manual trigger from the control thread: the hit is queued and starts at the beginning of
+    // the next process() call. Returns false if too many hits are already waiting.
+    bool triggerPad(int padIndex, float velocity);
     
     // Pattern sequencer
     void setPattern(int patternIndex);
@@ -64,6 +80,7 @@ public:
     void setStepFlam(int padIndex, int stepIndex, bool flam);
     void setSwing(float amount);
     void setTempo(float bpm);
+    void setRandomSeed(uint64_t seed);     // step probability draws are a function of (seed, pad, step count)
     
     // Bass synth controls
     void setBassNote(int noteNumber);
@@ -86,6 +103,24 @@ private:
     // Pads
     std::array<PadConfig, NUM_PADS> pads_;
     
+    // Pad samples, published to the audio thread as one immutable snapshot
+    struct PadSamples {
+        std::array<std::shared_ptr<const sample::StreamedSample>, NUM_PADS> pads;
+    };
+    std::shared_ptr<const PadSamples> samplesCtl_ = std::make_shared<const PadSamples>();
+    SnapshotExchange<PadSamples> samplesLive_;
+    const PadSamples* samples_ = nullptr;        // audio thread
+    sample::SampleStreamer* streamer_ = nullptr; // set with the first loaded sample
+    std::vector<float> windows_;                 // per voice and channel: streamed frames around the read position
+    uint32_t windowFrames_ = 0;
+    uint32_t chunkFrames_ = 0;
+    dsp::Interp interp_ = dsp::Interp::Sinc16;
+    std::array<uint32_t, NUM_PADS> padLoads_{};  // per pad, bumped by every load and clear
+    std::shared_ptr<char> alive_ = std::make_shared<char>(); // loader callbacks skip a deleted instance
+    void adoptSample(int padIndex, std::shared_ptr<const sample::StreamedSample> loaded);
+    void publishSample(int padIndex, std::shared_ptr<const sample::StreamedSample> sample);
+    void refreshSamples();
+    
     // Patterns
     std::array<Pattern, NUM_PATTERNS> patterns_;
     int currentPattern_ = 0;
@@ -94,17 +129,36 @@ private:
     bool playing_ = false;
     float tempo_ = 120.0f;
     int currentStep_ = 0;
+    uint64_t stepCount_ = 0;    // steps advanced since reset, keys the probability draws
+    uint64_t seed_ = 0;
     double sampleCounter_ = 0.0;
     double samplesPerStep_ = 0.0;
     
+    // Manual triggers on their way to the audio thread
+    struct Trigger {
+        int padIndex;
+        float velocity;
+    };
+    static constexpr int MAX_PENDING_TRIGGERS = 64;
+    SpscQueue<Trigger> triggers_{MAX_PENDING_TRIGGERS};
+    
     // Voice management
     struct Voice {
         int padIndex = -1;
-        float position = 0.0f;
+        const sample::StreamedSample* sample = nullptr;
+        double position = 0.0;  // read position in the sample, in its frames
+        uint64_t windowFirst = 0; // sample frame at the start of the voice's window
+        uint32_t held = 0;      // frames in the window
+        int stream = -1;        // SampleStreamer stream, -1 while playing from the head only
         float velocity = 1.0f;
         bool active = false;
     };
     std::array<Voice, MAX_VOICES> voices_;
+    float* window(int voiceIndex, int channel) {
+        return windows_.data() + (static_cast<size_t>(voiceIndex) * sample::StreamedSample::kMaxChannels + channel) * windowFrames_;
+    }
+    void fillWindow(int voiceIndex, uint64_t upTo);
+    void slideWindow(int voiceIndex, uint64_t keepFrom);
     
     // Bass synth
     float bassPhase_ = 0.0f;
@@ -119,7 +173,7 @@ private:
     void processVoices(const AudioBlock& block);
     void processBass(const AudioBlock& block);
     int allocateVoice(int padIndex, float velocity);
-    float processPad(int padIndex, float position, float velocity);
+    void stopVoice(Voice& voice);
 };
 
 } // namespace mydaw::plugins::rhythm_composer
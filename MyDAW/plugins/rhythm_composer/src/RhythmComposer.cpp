@@ -1,22 +1,44 @@
 #include "../include/RhythmComposer.h"
+#include "dsp/CounterRng.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace mydaw::plugins::rhythm_composer {
 
 RhythmComposer::RhythmComposer() = default;
-RhythmComposer::~RhythmComposer() = default;
+
+RhythmComposer::~RhythmComposer() {
+    for (auto& voice : voices_) {
+        if (voice.active) stopVoice(voice);
+    }
+}
 
 void RhythmComposer::prepare(double sampleRate, int maxBlockSize) {
     sampleRate_ = sampleRate;
     samplesPerStep_ = (60.0 / tempo_) * sampleRate / 4.0; // 16th notes
+    // Voices stream in chunks no longer than a block or half a ring of the shared streamer. The
+    // bound is fixed here, off the audio thread, as the streamer itself is only opened with the
+    // first sample and loads may land while process() runs
+    chunkFrames_ = std::min(static_cast<uint32_t>(std::max(maxBlockSize, 1)), sample::SampleStreamer::kDefaultRingFrames / 2);
+    // A window holds a chunk plus the interpolator's reach on either side
+    windowFrames_ = chunkFrames_ + 2 * dsp::kMaxInterpReach + 4;
+    windows_.assign(static_cast<size_t>(MAX_VOICES) * sample::StreamedSample::kMaxChannels * windowFrames_, 0.0f);
+    dsp::warm_resampler();
 }
 
 void RhythmComposer::process(const AudioBlock& block) {
     // Clear output
-    for (int ch = 0; ch < 2; ++ch) {
-        for (int i = 0; i < block.frames; ++i) {
-            block.out[ch][i] = 0.0f;
-        }
+    for (int ch = 0; ch < block.channels; ++ch) {
+        std::fill_n(block.out[ch], block.frames, 0.0f);
+    }
+    
+    refreshSamples();
+    
+    // Manual triggers queued since the last block
+    while (const Trigger* t = triggers_.front()) {
+        allocateVoice(t->padIndex, t->velocity);
+        triggers_.pop();
     }
     
     if (playing_) {
@@ -27,38 +49,89 @@ void RhythmComposer::process(const AudioBlock& block) {
     processBass(block);
 }
 
-void RhythmComposer::loadSample(int padIndex, const std::string& filepath) {
-    // Placeholder for sample loading
+bool RhythmComposer::loadSample(int padIndex, const std::string& filepath) {
+    if (padIndex < 0 || padIndex >= NUM_PADS) return false;
+    std::string err;
+    auto loaded = sample::SamplePool::shared().stream(filepath, err); // shared with other instances
+    if (!loaded) return false; // the pad keeps what it had
+    ++padLoads_[padIndex]; // supersedes any load still in flight
+    adoptSample(padIndex, std::move(loaded));
+    return true;
+}
+
+void RhythmComposer::loadSampleAsync(int padIndex, const std::string& filepath, sample::Deadline deadline, std::function<void(bool)> done) {
+    if (padIndex < 0 || padIndex >= NUM_PADS) {
+        if (done) done(false);
+        return;
+    }
+    const uint32_t serial = ++padLoads_[padIndex];
+    std::weak_ptr<char> alive = alive_;
+    sample::SampleLoader::shared().stream(filepath, deadline,
+        [this, alive, padIndex, serial, done = std::move(done)](std::shared_ptr<const sample::StreamedSample> loaded, const std::string&) {
+            // Runs in poll(), on the control thread: drop it if the instance or the request is gone
+            const bool ok = loaded && !alive.expired() && padLoads_[padIndex] == serial;
+            if (ok) adoptSample(padIndex, std::move(loaded));
+            if (done) done(ok);
+        });
+}
+
+void RhythmComposer::adoptSample(int padIndex, std::shared_ptr<const sample::StreamedSample> loaded) {
+    if (!streamer_) streamer_ = &sample::SampleStreamer::shared(); // published with the snapshot below
+    publishSample(padIndex, std::move(loaded));
+    pads_[padIndex].active = true;
 }
 
 void RhythmComposer::clearPad(int padIndex) {
     if (padIndex >= 0 && padIndex < NUM_PADS) {
-        pads_[padIndex].sample.clear();
+        ++padLoads_[padIndex];
+        publishSample(padIndex, nullptr);
         pads_[padIndex].active = false;
     }
 }
 
-void RhythmComposer::triggerPad(int padIndex, float velocity) {
-    allocateVoice(padIndex, velocity);
+void RhythmComposer::publishSample(int padIndex, std::shared_ptr<const sample::StreamedSample> loaded) {
+    auto next = std::make_shared<PadSamples>(*samplesCtl_);
+    next->pads[padIndex] = std::move(loaded);
+    samplesCtl_ = std::move(next);
+    samplesLive_.publish(samplesCtl_);
+}
+
+void RhythmComposer::refreshSamples() {
+    const PadSamples* next = samplesLive_.acquire();
+    if (next == samples_) return;
+    samples_ = next;
+    // The previous snapshot may be freed from here on: stop voices whose sample was replaced
+    for (auto& voice : voices_) {
+        if (voice.active && next->pads[voice.padIndex].get() != voice.sample) {
+            stopVoice(voice);
+        }
+    }
+}
+
+bool RhythmComposer::triggerPad(int padIndex, float velocity) {
+    if (padIndex < 0 || padIndex >= NUM_PADS) return false;
+    return triggers_.push(Trigger{padIndex, velocity});
 }
 
 void RhythmComposer::start() { playing_ = true; }
 void RhythmComposer::stop() { playing_ = false; }
-void RhythmComposer::reset() { currentStep_ = 0; sampleCounter_ = 0.0; }
+void RhythmComposer::reset() { currentStep_ = 0; stepCount_ = 0; sampleCounter_ = 0.0; }
 
 void RhythmComposer::processSequencer() {
     sampleCounter_ += 1.0;
     if (sampleCounter_ >= samplesPerStep_) {
         sampleCounter_ -= samplesPerStep_;
         currentStep_ = (currentStep_ + 1) % 16;
+        ++stepCount_;
         
         // Trigger active steps
         for (int pad = 0; pad < NUM_PADS; ++pad) {
             const auto& step = patterns_[currentPattern_].steps[pad][currentStep_];
             if (step.active) {
-                // Check probability
-                if (static_cast<float>(rand()) / RAND_MAX < step.probability) {
-                    triggerPad(pad, step.velocity);
+                // Check probability (reproducible across renders for a given seed)
+                const uint64_t h = dsp::CounterRng::hash(seed_, static_cast<uint64_t>(pad), stepCount_);
+                if (dsp::CounterRng::unit(h) < step.probability) {
+                    allocateVoice(pad, step.velocity);
                 }
             }
         }
@@ -66,59 +139,108 @@ void RhythmComposer::processSequencer() {
 }
 
 void RhythmComposer::processVoices(const AudioBlock& block) {
-    for (auto& voice : voices_) {
+    // A mono block gets both pan halves summed into its single channel
+    float* left = block.out[0];
+    float* right = block.out[block.channels > 1 ? 1 : 0];
+    for (int v = 0; v < MAX_VOICES; ++v) {
+        Voice& voice = voices_[v];
         if (!voice.active) continue;
         
-        for (int i = 0; i < block.frames; ++i) {
-            float sample = processPad(voice.padIndex, voice.position, voice.velocity);
-            
-            const auto& pad = pads_[voice.padIndex];
-            float panL = 1.0f - pad.pan;
-            float panR = pad.pan;
-            
-            block.out[0][i] += sample * panL;
-            block.out[1][i] += sample * panR;
-            
-            voice.position += 1.0f;
-            
-            if (voice.position >= pads_[voice.padIndex].sample.size()) {
-                voice.active = false;
-                break;
+        const auto& pad = pads_[voice.padIndex];
+        const float panL = (1.0f - pad.pan) * voice.velocity;
+        const float panR = pad.pan * voice.velocity;
+        const float* winL = window(v, 0);
+        const float* winR = window(v, voice.sample->channels() > 1 ? 1 : 0); // mono feeds both sides
+        
+        // Tuning and the sample's own rate set the read speed; at exactly 1 frames are copied
+        const float rate = static_cast<float>(std::exp2(pad.tuning / 12.0) * voice.sample->sampleRate() / sampleRate_);
+        const bool direct = rate == 1.0f && voice.position == std::floor(voice.position);
+        const int chunk = std::max(1, static_cast<int>(static_cast<float>(chunkFrames_) / rate));
+        
+        for (int done = 0; done < block.frames && voice.active;) {
+            int n = std::min(block.frames - done, chunk);
+            // Keep the interpolator's history behind the read position, stream in what n frames reach
+            const uint64_t at = static_cast<uint64_t>(voice.position);
+            slideWindow(v, at > dsp::kMaxInterpReach ? at - dsp::kMaxInterpReach : 0);
+            fillWindow(v, static_cast<uint64_t>(voice.position + (n - 1) * static_cast<double>(rate)) + dsp::kMaxInterpReach + 1);
+            const double offset = voice.position - static_cast<double>(voice.windowFirst);
+            if (direct) {
+                n = static_cast<int>(std::min<double>(n, voice.held - offset));
+                dsp::mix_ramp(left + done, winL + static_cast<size_t>(offset), panL, 0.0f, n);
+                dsp::mix_ramp(right + done, winR + static_cast<size_t>(offset), panR, 0.0f, n);
+            } else {
+                // Frames past the window are past the sample's end and read as silence
+                dsp::mix_resample(interp_, left + done, winL, voice.held, offset, rate, panL, 0.0f, n);
+                dsp::mix_resample(interp_, right + done, winR, voice.held, offset, rate, panR, 0.0f, n);
             }
+            voice.position += n * static_cast<double>(rate);
+            done += n;
+            if (n <= 0 || voice.position >= static_cast<double>(voice.sample->frames())) stopVoice(voice); // reached the end of the sample
         }
     }
 }
 
+void RhythmComposer::slideWindow(int voiceIndex, uint64_t keepFrom) {
+    Voice& voice = voices_[voiceIndex];
+    if (keepFrom <= voice.windowFirst) return;
+    const uint32_t drop = static_cast<uint32_t>(std::min<uint64_t>(keepFrom - voice.windowFirst, voice.held));
+    for (int c = 0; c < voice.sample->channels(); ++c) {
+        float* w = window(voiceIndex, c);
+        std::memmove(w, w + drop, sizeof(float) * (voice.held - drop));
+    }
+    voice.windowFirst += drop;
+    voice.held -= drop;
+}
+
+void RhythmComposer::fillWindow(int voiceIndex, uint64_t upTo) {
+    Voice& voice = voices_[voiceIndex];
+    upTo = std::min(upTo, voice.sample->frames());
+    while (voice.windowFirst + voice.held < upTo && voice.held < windowFrames_) {
+        const uint32_t want = static_cast<uint32_t>(std::min<uint64_t>({upTo - voice.windowFirst - voice.held, windowFrames_ - voice.held, chunkFrames_}));
+        float* out[sample::StreamedSample::kMaxChannels] = { window(voiceIndex, 0) + voice.held, window(voiceIndex, 1) + voice.held };
+        const uint32_t got = streamer_->read(voice.stream, *voice.sample, voice.windowFirst + voice.held, want, out);
+        voice.held += got;
+        if (got < want) break;
+    }
+}
+
 void RhythmComposer::processBass(const AudioBlock& block) {
     // Simple bass synthesis placeholder
 }
 
 int RhythmComposer::allocateVoice(int padIndex, float velocity) {
+    // Audio thread only, after process() has refreshed samples_
+    if (padIndex < 0 || padIndex >= NUM_PADS) return -1;
+    if (!samples_ || !samples_->pads[padIndex] || chunkFrames_ == 0) return -1;
     for (int i = 0; i < MAX_VOICES; ++i) {
-        if (!voices_[i].active) {
-            voices_[i].padIndex = padIndex;
-            voices_[i].position = 0.0f;
-            voices_[i].velocity = velocity;
-            voices_[i].active = true;
+        Voice& voice = voices_[i];
+        if (!voice.active) {
+            voice.padIndex = padIndex;
+            voice.sample = samples_->pads[padIndex].get();
+            voice.position = 0.0;
+            voice.windowFirst = 0;
+            voice.held = 0;
+            voice.stream = streamer_->open(samples_->pads[padIndex]); // starts the read-ahead
+            voice.velocity = velocity;
+            voice.active = true;
             return i;
         }
     }
     return -1;
 }
 
-float RhythmComposer::processPad(int padIndex, float position, float velocity) {
-    if (padIndex < 0 || padIndex >= NUM_PADS) return 0.0f;
-    
-    const auto& pad = pads_[padIndex];
-    if (pad.sample.empty()) return 0.0f;
-    
-    int idx = static_cast<int>(position);
-    if (idx >= static_cast<int>(pad.sample.size())) return 0.0f;
-    
-    return pad.sample[idx] * velocity;
+void RhythmComposer::stopVoice(Voice& voice) {
+    if (streamer_) streamer_->close(voice.stream);
+    voice.stream = -1;
+    voice.sample = nullptr;
+    voice.active = false;
 }
 
-void RhythmComposer::setPadTuning(int padIndex, float semitones) {}
+void RhythmComposer::setPadTuning(int padIndex, float semitones) {
+    if (padIndex >= 0 && padIndex < NUM_PADS) {
+        pads_[padIndex].tuning = std::clamp(semitones, -12.0f, 12.0f);
+    }
+}
 void RhythmComposer::setPadDecay(int padIndex, float decay) {}
 void RhythmComposer::setPadFilter(int padIndex, float cutoff) {}
 void RhythmComposer::setPadPan(int padIndex, float pan) {
@@ -127,12 +249,14 @@ void RhythmComposer::setPadPan(int padIndex, float pan) {
     }
 }
 void RhythmComposer::setPadDrive(int padIndex, float drive) {}
+void RhythmComposer::setInterpolation(dsp::Interp quality) { interp_ = quality; }
 void RhythmComposer::setPattern(int patternIndex) { currentPattern_ = patternIndex; }
 void RhythmComposer::setStep(int padIndex, int stepIndex, bool active, float velocity) {}
 void RhythmComposer::setStepProbability(int padIndex, int stepIndex, float prob) {}
 void RhythmComposer::setStepFlam(int padIndex, int stepIndex, bool flam) {}
 void RhythmComposer::setSwing(float amount) {}
 void RhythmComposer::setTempo(float bpm) { tempo_ = bpm; }
+void RhythmComposer::setRandomSeed(uint64_t seed) { seed_ = seed; }
 void RhythmComposer::setBassNote(int noteNumber) {}
 void RhythmComposer::setBassDecay(float decay) {}
 void RhythmComposer::setBassFilter(float cutoff) {}
@@ -1,4 +1,5 @@
 #include "../include/SonnetComposer.h"
+#include <algorithm>
 
 namespace mydaw::plugins::sonnet_composer {
 
@@ -10,10 +11,8 @@ void SonnetComposer::prepare(double sampleRate, int maxBlockSize) {
 }
 
 void SonnetComposer::process(const AudioBlock& block) {
-    for (int ch = 0; ch < 2; ++ch) {
-        for (int i = 0; i < block.frames; ++i) {
-            block.out[ch][i] = 0.0f;
-        }
+    for (int ch = 0; ch < block.channels; ++ch) {
+        std::fill_n(block.out[ch], block.frames, 0.0f);
     }
 }
 
@@ -32,6 +32,7 @@ public:
 
     void prepare(double sampleRate, int maxBlockSize) override;
     void process(const AudioBlock& block) override;
+    bool processesInPlace() const override { return true; }
     int latencySamples() const override { return 0; }
 
     void setBand(int index, const EQBand& band);
@@ -1,4 +1,5 @@
 #include "../include/VelocityEQ.h"
+#include <algorithm>
 
 namespace mydaw::plugins::velocity_eq {
 
@@ -10,11 +11,10 @@ void VelocityEQ::prepare(double sampleRate, int maxBlockSize) {
 }
 
 void VelocityEQ::process(const AudioBlock& block) {
-    // Pass-through for now
-    for (int ch = 0; ch < 2; ++ch) {
-        for (int i = 0; i < block.frames; ++i) {
-            block.out[ch][i] = block.in[ch][i];
-        }
+    // Pass-through for now; nothing to do when the graph runs us in place
+    if (block.inPlace) return;
+    for (int ch = 0; ch < block.channels; ++ch) {
+        std::copy_n(block.in[ch], block.frames, block.out[ch]);
     }
 }
 
@@ -0,0 +1,165 @@
+#include "MappedWav.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+namespace mydaw::sample {
+namespace {
+uint16_t le16(const uint8_t* p){ return (uint16_t)(p[0] | p[1] << 8); }
+uint32_t le32(const uint8_t* p){ return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+uint16_t be16(const uint8_t* p){ return (uint16_t)(p[0] << 8 | p[1]); }
+uint32_t be32(const uint8_t* p){ return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | (uint32_t)p[3]; }
+// 80-bit IEEE extended, as AIFF stores its sample rate.
+double be_extended(const uint8_t* p){
+  const int exponent = (int)(be16(p) & 0x7FFF) - 16383 - 63;
+  const uint64_t mantissa = (uint64_t)be32(p + 2) << 32 | be32(p + 6);
+  const double v = std::ldexp((double)mantissa, exponent);
+  return p[0] & 0x80 ? -v : v;
+}
+constexpr uint16_t kFormatPcm = 1, kFormatFloat = 3, kFormatExtensible = 0xFFFE;
+} // namespace
+bool parse_wav(const uint8_t* file, size_t size, WavInfo& info, std::string& err){
+  if (size < 12 || std::memcmp(file, "RIFF", 4) || std::memcmp(file + 8, "WAVE", 4)){ err = "not a RIFF/WAVE file"; return false; }
+  bool haveFmt = false;
+  uint16_t tag = 0, bits = 0;
+  for (size_t pos = 12; pos + 8 <= size;){
+    const uint8_t* chunk = file + pos;
+    const uint64_t len = le32(chunk + 4);
+    const uint8_t* body = chunk + 8;
+    if (!std::memcmp(chunk, "fmt ", 4)){
+      if (len < 16 || pos + 8 + len > size){ err = "truncated fmt chunk"; return false; }
+      tag = le16(body);
+      info.channels = le16(body + 2);
+      info.sr = le32(body + 4);
+      info.blockAlign = le16(body + 12);
+      bits = le16(body + 14);
+      if (tag == kFormatExtensible && len >= 26) tag = le16(body + 24); // first two bytes of the subformat GUID
+      haveFmt = true;
+    } else if (!std::memcmp(chunk, "data", 4)){
+      if (!haveFmt){ err = "data chunk before fmt"; return false; }
+      if (info.channels <= 0 || info.sr <= 0 || info.blockAlign == 0){ err = "bad fmt chunk"; return false; }
+      if (tag == kFormatPcm && bits == 16) info.format = PcmFormat::Int16;
+      else if (tag == kFormatPcm && bits == 24) info.format = PcmFormat::Int24;
+      else if (tag == kFormatPcm && bits == 32) info.format = PcmFormat::Int32;
+      else if (tag == kFormatFloat && bits == 32) info.format = PcmFormat::Float32;
+      else { err = "unsupported sample format"; return false; }
+      if (info.blockAlign < (uint32_t)info.channels * (bits / 8)){ err = "bad block align"; return false; }
+      info.dataOffset = pos + 8;
+      info.frames = std::min<uint64_t>(len, size - info.dataOffset) / info.blockAlign; // tolerate truncated files
+      return true;
+    }
+    pos += 8 + len + (len & 1);
+  }
+  err = haveFmt ? "no data chunk" : "no fmt chunk";
+  return false;
+}
+bool parse_aiff(const uint8_t* file, size_t size, WavInfo& info, std::string& err){
+  if (size < 12 || std::memcmp(file, "FORM", 4) || (std::memcmp(file + 8, "AIFF", 4) && std::memcmp(file + 8, "AIFC", 4))){ err = "not an AIFF file"; return false; }
+  const bool aifc = !std::memcmp(file + 8, "AIFC", 4);
+  bool haveComm = false, little = false, isFloat = false;
+  uint16_t bits = 0;
+  for (size_t pos = 12; pos + 8 <= size;){
+    const uint8_t* chunk = file + pos;
+    const uint64_t len = be32(chunk + 4);
+    const uint8_t* body = chunk + 8;
+    if (!std::memcmp(chunk, "COMM", 4)){
+      if (len < (aifc ? 22u : 18u) || pos + 8 + len > size){ err = "truncated COMM chunk"; return false; }
+      info.channels = be16(body);
+      info.frames = be32(body + 2);
+      bits = be16(body + 6);
+      info.sr = be_extended(body + 8);
+      if (aifc){
+        if (!std::memcmp(body + 18, "sowt", 4)) little = true;
+        else if (!std::memcmp(body + 18, "fl32", 4) || !std::memcmp(body + 18, "FL32", 4)) isFloat = true;
+        else if (std::memcmp(body + 18, "NONE", 4) && std::memcmp(body + 18, "twos", 4)){ err = "unsupported AIFF-C compression"; return false; }
+      }
+      haveComm = true;
+    } else if (!std::memcmp(chunk, "SSND", 4)){
+      if (!haveComm){ err = "SSND chunk before COMM"; return false; }
+      if (info.channels <= 0 || info.sr <= 0 || len < 8){ err = "bad COMM chunk"; return false; }
+      if (isFloat && bits == 32) info.format = PcmFormat::Float32;
+      else if (!isFloat && bits == 16) info.format = PcmFormat::Int16;
+      else if (!isFloat && !little && bits == 24) info.format = PcmFormat::Int24;
+      else if (!isFloat && !little && bits == 32) info.format = PcmFormat::Int32;
+      else { err = "unsupported sample format"; return false; }
+      info.bigEndian = !little;
+      info.blockAlign = (uint32_t)info.channels * (bits / 8);
+      info.dataOffset = pos + 16 + be32(body); // the SSND offset field skips any block padding
+      if (info.dataOffset > size){ err = "bad SSND chunk"; return false; }
+      info.frames = std::min<uint64_t>(info.frames, (size - info.dataOffset) / info.blockAlign); // tolerate truncated files
+      return true;
+    }
+    pos += 8 + len + (len & 1);
+  }
+  err = haveComm ? "no SSND chunk" : "no COMM chunk";
+  return false;
+}
+void decode_pcm(const WavInfo& info, const uint8_t* file, uint64_t first, uint32_t n, float* const* out, int outChannels){
+  const uint8_t* frame = file + info.dataOffset + first * info.blockAlign;
+  const int bytes = info.format == PcmFormat::Int16 ? 2 : info.format == PcmFormat::Int24 ? 3 : 4;
+  for (int c = 0; c < outChannels; ++c){
+    const uint8_t* p = frame + (size_t)std::min(c, info.channels - 1) * (size_t)bytes;
+    float* d = out[c];
+    if (info.bigEndian){
+      switch (info.format){
+        case PcmFormat::Int16:
+          for (uint32_t i = 0; i < n; ++i, p += info.blockAlign) d[i] = (float)(int16_t)be16(p) * (1.0f / 32768.0f);
+          break;
+        case PcmFormat::Int24:
+          for (uint32_t i = 0; i < n; ++i, p += info.blockAlign) d[i] = (float)((int32_t)((uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8) >> 8) * (1.0f / 8388608.0f);
+          break;
+        case PcmFormat::Int32:
+          for (uint32_t i = 0; i < n; ++i, p += info.blockAlign) d[i] = (float)(int32_t)be32(p) * (1.0f / 2147483648.0f);
+          break;
+        case PcmFormat::Float32:
+          for (uint32_t i = 0; i < n; ++i, p += info.blockAlign){ const uint32_t u = be32(p); std::memcpy(&d[i], &u, 4); }
+          break;
+      }
+      continue;
+    }
+    switch (info.format){
+      case PcmFormat::Int16:
+        for (uint32_t i = 0; i < n; ++i, p += info.blockAlign) d[i] = (float)(int16_t)le16(p) * (1.0f / 32768.0f);
+        break;
+      case PcmFormat::Int24:
+        for (uint32_t i = 0; i < n; ++i, p += info.blockAlign) d[i] = (float)((int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8) * (1.0f / 8388608.0f);
+        break;
+      case PcmFormat::Int32:
+        for (uint32_t i = 0; i < n; ++i, p += info.blockAlign) d[i] = (float)(int32_t)le32(p) * (1.0f / 2147483648.0f);
+        break;
+      case PcmFormat::Float32:
+        for (uint32_t i = 0; i < n; ++i, p += info.blockAlign){ const uint32_t u = le32(p); std::memcpy(&d[i], &u, 4); }
+        break;
+    }
+  }
+}
+MappedFile::~MappedFile(){ if (data_) munmap(const_cast<uint8_t*>(data_), size_); }
+bool MappedFile::open(const std::string& path, std::string& err){
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0){ err = "cannot open " + path; return false; }
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || st.st_size <= 0){ ::close(fd); err = "cannot read " + path; return false; }
+  void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED){ err = "cannot map " + path; return false; }
+  if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+  data_ = static_cast<const uint8_t*>(p); size_ = (size_t)st.st_size;
+  madvise(p, size_, MADV_SEQUENTIAL);
+  return true;
+}
+void MappedFile::prefetch(uint64_t offset, uint64_t len) const{
+  if (!data_ || offset >= size_) return;
+  const uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+  const uint64_t beg = offset / page * page;
+  madvise(const_cast<uint8_t*>(data_) + beg, (size_t)std::min<uint64_t>(offset + len, size_) - beg, MADV_WILLNEED);
+}
+bool MappedWav::open(const std::string& path, std::string& err){
+  if (!file_.open(path, err)) return false;
+  const bool aiff = file_.size() >= 4 && !std::memcmp(file_.data(), "FORM", 4);
+  if (!(aiff ? parse_aiff : parse_wav)(file_.data(), file_.size(), info_, err)){ err = path + ": " + err; return false; }
+  return true;
+}
+} // namespace
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+namespace mydaw::sample {
+enum class PcmFormat : uint8_t{ Int16, Int24, Int32, Float32 };
+struct WavInfo{
+  PcmFormat format{PcmFormat::Int16};
+  int channels{0};
+  double sr{0};
+  uint64_t frames{0};
+  uint32_t blockAlign{0};   // bytes per interleaved frame
+  uint64_t dataOffset{0};   // of the first frame, from the start of the file
+  bool bigEndian{false};    // AIFF
+};
+// Reads the RIFF/WAVE header: PCM 16/24/32-bit, IEEE float 32, plain or WAVE_FORMAT_EXTENSIBLE.
+bool parse_wav(const uint8_t* file, size_t size, WavInfo& info, std::string& err);
+// Reads an AIFF or AIFF-C header: PCM 16/24/32-bit, and AIFF-C 'sowt' (little-endian 16-bit)
+// and 'fl32' (float 32).
+bool parse_aiff(const uint8_t* file, size_t size, WavInfo& info, std::string& err);
+// Converts frames [first, first+n) of the data chunk to planar float. Output channels past the
+// file's repeat its last channel; file channels past outChannels are dropped.
+void decode_pcm(const WavInfo& info, const uint8_t* file, uint64_t first, uint32_t n, float* const* out, int outChannels);
+// A read-only memory mapping of a whole file. Pages fault in on first touch, so only the
+// thread that decodes (never the audio thread) should read through it.
+class MappedFile{
+  const uint8_t* data_{nullptr};
+  size_t size_{0};
+public:
+  MappedFile()=default;
+  ~MappedFile();
+  MappedFile(const MappedFile&)=delete;
+  MappedFile& operator=(const MappedFile&)=delete;
+  bool open(const std::string& path, std::string& err);
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  // Hints the kernel to start reading [offset, offset+len) in the background.
+  void prefetch(uint64_t offset, uint64_t len) const;
+};
+// A mapped WAV or AIFF file, decoded on demand.
+class MappedWav{
+  MappedFile file_;
+  WavInfo info_;
+public:
+  bool open(const std::string& path, std::string& err);
+  const WavInfo& info() const { return info_; }
+  void decode(uint64_t first, uint32_t n, float* const* out, int outChannels) const { decode_pcm(info_, file_.data(), first, n, out, outChannels); }
+  void prefetch(uint64_t first, uint64_t n) const { file_.prefetch(info_.dataOffset + first*info_.blockAlign, n*info_.blockAlign); }
+};
+} // namespace
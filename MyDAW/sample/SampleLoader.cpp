@@ -0,0 +1,160 @@
+#include "SampleLoader.h"
+#include <algorithm>
+namespace mydaw::sample {
+namespace {
+void lower(std::atomic<Deadline>& at, Deadline d){
+  for (Deadline cur = at.load(std::memory_order_relaxed); d < cur && !at.compare_exchange_weak(cur, d, std::memory_order_relaxed);){}
+}
+} // namespace
+const SampleData* LazySample::get(){
+  const uint8_t s = state_.load(std::memory_order_acquire);
+  if (s == Ready) return audio_.get();
+  if (s == Idle) request();
+  return nullptr;
+}
+void LazySample::request(Deadline deadline){
+  lower(deadline_, deadline); // a queued load is picked by its current deadline
+  uint8_t expected = Idle;
+  if (state_.compare_exchange_strong(expected, Requested, std::memory_order_acq_rel)) loader_->wake();
+}
+SampleLoader::SampleLoader(int workers){
+  SamplePool::shared(); // constructed first, so the process-wide pool outlives the shared loader
+  if (workers <= 0) workers = (int)std::max(1u, std::thread::hardware_concurrency());
+  for (int i = 0; i < workers; ++i) threads_.emplace_back([this]{ run(); });
+}
+SampleLoader::~SampleLoader(){
+  stop_.store(true, std::memory_order_release);
+  wake();
+  for (auto& t : threads_) t.join();
+  for (Done* d = done_.exchange(nullptr); d;){ Done* next = d->next; delete d; d = next; } // callbacks not polled
+}
+SampleLoader& SampleLoader::shared(){
+  static SampleLoader instance;
+  return instance;
+}
+std::shared_ptr<LazySample> SampleLoader::make(std::string path, SampleEncoding encoding){
+  auto s = std::make_shared<LazySample>(std::move(path), encoding, *this);
+  std::lock_guard<std::mutex> lk(mu_);
+  watched_.erase(std::remove_if(watched_.begin(), watched_.end(), [](const auto& w){ return w.expired(); }), watched_.end());
+  watched_.push_back(s);
+  return s;
+}
+void SampleLoader::prefetch(const std::shared_ptr<LazySample>& s, Deadline deadline, std::function<void(const LazySample&)> done){
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    const uint8_t state = s->state_.load(std::memory_order_acquire);
+    if (state == LazySample::Ready || state == LazySample::Failed){
+      if (done) finish([s, done = std::move(done)]{ done(*s); });
+      return;
+    }
+    lower(s->deadline_, deadline);
+    if (done) s->waiters_.push_back(std::move(done));
+    if (state != LazySample::Queued) queue(s);
+  }
+  wake();
+}
+void SampleLoader::stream(std::string path, Deadline deadline, StreamDone done){
+  auto job = [this, path = std::move(path), done = std::move(done)]{
+    std::string err;
+    auto s = SamplePool::shared().stream(path, err);
+    if (!s) failed_.fetch_add(1, std::memory_order_relaxed);
+    finish([done, s = std::move(s), err = std::move(err)]{ if (done) done(s, err); });
+  };
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    jobs_.push_back(Job{deadline, seq_++, std::move(job)});
+    std::push_heap(jobs_.begin(), jobs_.end(), std::greater<>());
+    queued_.fetch_add(1, std::memory_order_release);
+  }
+  wake();
+}
+size_t SampleLoader::poll(){
+  Done* fifo = nullptr; // the stack holds the latest first
+  for (Done* d = done_.exchange(nullptr, std::memory_order_acquire); d;){ Done* next = d->next; d->next = fifo; fifo = d; d = next; }
+  size_t ran = 0;
+  while (fifo){
+    std::unique_ptr<Done> d(fifo);
+    fifo = d->next;
+    d->fn();
+    ++ran;
+  }
+  return ran;
+}
+void SampleLoader::drain(){
+  for (uint64_t f; (f = finished_.load(std::memory_order_acquire)) < queued_.load(std::memory_order_acquire);) finished_.wait(f, std::memory_order_acquire);
+  poll();
+}
+SampleLoader::Progress SampleLoader::progress() const{
+  Progress p;
+  p.finished = finished_.load(std::memory_order_acquire);
+  p.queued = queued_.load(std::memory_order_acquire);
+  p.failed = failed_.load(std::memory_order_relaxed);
+  return p;
+}
+// Under mu_.
+void SampleLoader::queue(const std::shared_ptr<LazySample>& s){
+  s->state_.store(LazySample::Queued, std::memory_order_release);
+  pending_.push_back(Pending{s, seq_++});
+  queued_.fetch_add(1, std::memory_order_release);
+}
+// Under mu_: takes on the LazySamples requested since the last scan.
+void SampleLoader::scan(){
+  for (const auto& w : watched_)
+    if (auto s = w.lock(); s && s->state_.load(std::memory_order_acquire) == LazySample::Requested) queue(s);
+}
+void SampleLoader::finish(std::function<void()> fn){
+  Done* d = new Done{done_.load(std::memory_order_relaxed), std::move(fn)};
+  while (!done_.compare_exchange_weak(d->next, d, std::memory_order_release, std::memory_order_relaxed)){}
+}
+void SampleLoader::load(const std::shared_ptr<LazySample>& s){
+  std::string err;
+  SampleRef audio = SamplePool::shared().load(s->path_, s->encoding_, err);
+  const bool ok = (bool)audio;
+  std::vector<std::function<void(const LazySample&)>> waiters;
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    s->audio_ = std::move(audio);
+    s->state_.store(ok ? LazySample::Ready : LazySample::Failed, std::memory_order_release);
+    waiters.swap(s->waiters_);
+  }
+  loaded_.fetch_add(1, std::memory_order_relaxed);
+  if (!ok) failed_.fetch_add(1, std::memory_order_relaxed);
+  if (!waiters.empty()) finish([s, waiters = std::move(waiters)]{ for (const auto& w : waiters) w(*s); });
+}
+void SampleLoader::run(){
+  for (;;){
+    const uint32_t seen = kick_.load(std::memory_order_acquire);
+    if (stop_.load(std::memory_order_acquire)) return;
+    std::shared_ptr<LazySample> lazy;
+    std::function<void()> job;
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (seen != scanned_){ scanned_ = seen; scan(); }
+      // Earliest deadline among the pending LazySamples (read now: requests may bring them
+      // forward while queued) and the jobs.
+      size_t best = pending_.size();
+      Deadline bestDeadline = kWhenIdle;
+      uint64_t bestSeq = UINT64_MAX;
+      for (size_t i = 0; i < pending_.size(); ++i){
+        const Deadline d = pending_[i].sample->deadline_.load(std::memory_order_relaxed);
+        if (std::tie(d, pending_[i].seq) < std::tie(bestDeadline, bestSeq)){ best = i; bestDeadline = d; bestSeq = pending_[i].seq; }
+      }
+      if (!jobs_.empty() && (best == pending_.size() || std::tie(jobs_.front().deadline, jobs_.front().seq) < std::tie(bestDeadline, bestSeq))){
+        std::pop_heap(jobs_.begin(), jobs_.end(), std::greater<>());
+        job = std::move(jobs_.back().run);
+        jobs_.pop_back();
+      } else if (best < pending_.size()){
+        lazy = std::move(pending_[best].sample);
+        pending_[best] = std::move(pending_.back());
+        pending_.pop_back();
+      }
+    }
+    if (lazy) load(lazy);
+    else if (job) job();
+    else { kick_.wait(seen, std::memory_order_acquire); continue; }
+    lazy.reset(); // may free a sample whose owners let go meanwhile, here rather than on their threads
+    finished_.fetch_add(1, std::memory_order_release);
+    finished_.notify_all();
+  }
+}
+} // namespace
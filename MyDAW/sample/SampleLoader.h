@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "SamplePool.h"
+namespace mydaw::sample {
+class SampleLoader;
+// When loaded work is needed, on any clock the caller keeps monotonic (say the engine frame at
+// which the playhead first reaches the sample). Smaller is sooner; equal deadlines run in order.
+using Deadline = uint64_t;
+constexpr Deadline kNow = 0;
+constexpr Deadline kWhenIdle = UINT64_MAX;
+// A sample file that is decoded into the SamplePool on first use, in the background. Create it
+// with SampleLoader::make(); the audio thread may then ask for it without blocking.
+class LazySample{
+  friend class SampleLoader;
+  enum State : uint8_t{ Idle, Requested, Queued, Ready, Failed };
+  std::string path_;
+  SampleEncoding encoding_;
+  SampleLoader* loader_;
+  std::atomic<uint8_t> state_{Idle};
+  std::atomic<Deadline> deadline_{kWhenIdle};
+  SampleRef audio_;   // written once by the loader before state_ turns Ready
+  std::vector<std::function<void(const LazySample&)>> waiters_; // under the loader's lock
+public:
+  LazySample(std::string path, SampleEncoding encoding, SampleLoader& loader)
+    : path_(std::move(path)), encoding_(encoding), loader_(&loader) {}
+  // Any thread: the audio once loaded, else null. The first call queues the load for now.
+  const SampleData* get();
+  // Any thread, the audio thread included: queue the load, or bring a queued one forward.
+  void request(Deadline deadline = kNow);
+  bool ready() const { return state_.load(std::memory_order_acquire) == Ready; }
+  bool failed() const { return state_.load(std::memory_order_acquire) == Failed; }
+  const std::string& path() const { return path_; }
+};
+// Loads sample files on a pool of worker threads, earliest deadline first, so opening a
+// session decodes its files in parallel while whatever the playhead needs next goes ahead.
+// Two kinds of work share the queue: LazySamples, whose requests only touch atomics and wake
+// the workers (so the audio thread may make them), and control-thread jobs from prefetch() and
+// stream(). Finished jobs go onto a lock-free stack; poll() runs their callbacks on the thread
+// that calls it, never on a worker.
+class SampleLoader{
+public:
+  struct Progress{
+    uint64_t queued{0};   // jobs taken on, LazySamples included
+    uint64_t finished{0}; // of those, done or failed
+    uint64_t failed{0};
+  };
+  // workers: decoding threads; 0 for one per core.
+  explicit SampleLoader(int workers = 0);
+  ~SampleLoader();
+  SampleLoader(const SampleLoader&)=delete;
+  SampleLoader& operator=(const SampleLoader&)=delete;
+  // Process-wide instance, created on first call; make that call off the audio thread.
+  static SampleLoader& shared();
+  // Control thread: a LazySample for path that this loader watches while it lives.
+  std::shared_ptr<LazySample> make(std::string path, SampleEncoding encoding = SampleEncoding::Int16);
+  // Control thread: loads s by deadline and calls done(s) from poll() once it is ready or has
+  // failed (from the next poll() if it already has).
+  void prefetch(const std::shared_ptr<LazySample>& s, Deadline deadline, std::function<void(const LazySample&)> done = {});
+  // Control thread: opens path for streaming through the SamplePool by deadline, then calls
+  // done(sample, err) from poll(); sample is null if the file cannot be opened.
+  using StreamDone = std::function<void(std::shared_ptr<const StreamedSample>, const std::string&)>;
+  void stream(std::string path, Deadline deadline, StreamDone done);
+  // Runs the callbacks of finished jobs, in the order they finished; returns how many ran.
+  size_t poll();
+  // Control thread: waits until every job queued so far has finished, then polls.
+  void drain();
+  Progress progress() const;
+  uint64_t loaded() const { return loaded_.load(std::memory_order_relaxed); }
+  int workers() const { return (int)threads_.size(); }
+private:
+  struct Job{
+    Deadline deadline; uint64_t seq; std::function<void()> run;
+    bool operator>(const Job& o) const { return std::tie(deadline, seq) > std::tie(o.deadline, o.seq); }
+  };
+  struct Pending{ std::shared_ptr<LazySample> sample; uint64_t seq; };
+  struct Done{ Done* next; std::function<void()> fn; };
+  std::mutex mu_;
+  std::vector<std::weak_ptr<LazySample>> watched_;
+  std::vector<Pending> pending_;   // LazySamples taken on, picked by their current deadline
+  std::vector<Job> jobs_;          // heap, earliest first
+  uint64_t seq_{0};
+  uint32_t scanned_{0};            // kick_ as of the last scan of watched_
+  std::atomic<Done*> done_{nullptr};
+  std::atomic<uint32_t> kick_{0};
+  std::atomic<bool> stop_{false};
+  std::atomic<uint64_t> loaded_{0}, queued_{0}, failed_{0};
+  std::atomic<uint64_t> finished_{0};
+  std::vector<std::thread> threads_;
+  void run();
+  void scan();
+  void queue(const std::shared_ptr<LazySample>& s);
+  void load(const std::shared_ptr<LazySample>& s);
+  void finish(std::function<void()> fn);
+  void wake(){ kick_.fetch_add(1, std::memory_order_release); kick_.notify_all(); }
+  friend class LazySample;
+};
+} // namespace
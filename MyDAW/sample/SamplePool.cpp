@@ -0,0 +1,170 @@
+#include "SamplePool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sys/stat.h>
+#include <tuple>
+#include <type_traits>
+namespace mydaw::sample {
+namespace {
+constexpr uint64_t kMul = 0x9e3779b97f4a7c15ull;
+uint64_t mix(uint64_t z){
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+} // namespace
+// Four independent multiply-rotate lanes over 32-byte stripes, folded at the end.
+uint64_t hash_bytes(const void* data, size_t len, uint64_t seed){
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint64_t h[4] = {seed ^ kMul, seed + kMul, seed * kMul, ~seed};
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32){
+    for (int k = 0; k < 4; ++k){
+      uint64_t w; std::memcpy(&w, p + i + 8*k, 8);
+      h[k] = ((h[k] ^ w) * kMul);
+      h[k] = (h[k] << 31) | (h[k] >> 33);
+    }
+  }
+  uint64_t r = mix(h[0] ^ mix(h[1] ^ mix(h[2] ^ mix(h[3] ^ len))));
+  for (; i < len; i += 8){
+    uint64_t w = 0; std::memcpy(&w, p + i, std::min<size_t>(8, len - i));
+    r = mix(r ^ w);
+  }
+  return r;
+}
+void SampleRef::release(){
+  if (d_ && d_->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) d_->pool_->retire(d_);
+  d_ = nullptr;
+}
+// Called once per entry, by whoever dropped its last reference.
+void SamplePool::retire(SampleData* d){
+  SampleData* head = dead_.load(std::memory_order_relaxed);
+  do d->nextDead_ = head; while (!dead_.compare_exchange_weak(head, d, std::memory_order_release, std::memory_order_relaxed));
+}
+SamplePool::~SamplePool(){
+  collect();
+  for (auto& [hash, d] : byHash_) delete d; // still referenced at exit; nobody can use them now
+}
+SamplePool& SamplePool::shared(){
+  static SamplePool instance;
+  return instance;
+}
+void SamplePool::collect(){
+  SampleData* d = dead_.exchange(nullptr, std::memory_order_acquire);
+  if (!d) return;
+  std::lock_guard<std::mutex> lk(mu_);
+  while (d){
+    SampleData* next = d->nextDead_;
+    // intern() never revives a zero count, so nothing can reach d any more but the table.
+    auto [b, e] = byHash_.equal_range(d->hash_);
+    for (auto it = b; it != e; ++it) if (it->second == d){ byHash_.erase(it); break; }
+    bytes_ -= d->bytes();
+    delete d;
+    d = next;
+  }
+}
+template<class T> SampleRef SamplePool::intern(SampleEncoding encoding, const T* const* channels, int channelCount, uint64_t frames, double sr){
+  collect();
+  uint64_t hash = hash_bytes(&sr, sizeof sr, (uint64_t)encoding << 56 ^ (uint64_t)channelCount << 48 ^ frames);
+  for (int c = 0; c < channelCount; ++c) hash = hash_bytes(channels[c], frames * sizeof(T), hash);
+  auto stored = [](SampleData* d){
+    if constexpr (std::is_same_v<T, float>) return &d->data_; else return &d->pcm16_;
+  };
+  std::lock_guard<std::mutex> lk(mu_);
+  auto [b, e] = byHash_.equal_range(hash);
+  for (auto it = b; it != e; ++it){
+    SampleData* d = it->second;
+    if (d->encoding_ != encoding || d->channels_ != channelCount || d->frames_ != frames || d->sr_ != sr) continue;
+    bool same = true;
+    for (int c = 0; c < channelCount && same; ++c) same = !std::memcmp(stored(d)->data() + (size_t)c * (frames + 1), channels[c], frames * sizeof(T));
+    if (!same) continue;
+    // A count already at zero belongs to an entry being retired: leave it to collect() and
+    // store a fresh copy below.
+    for (uint32_t r = d->refs_.load(std::memory_order_relaxed); r;)
+      if (d->refs_.compare_exchange_weak(r, r + 1, std::memory_order_acquire, std::memory_order_relaxed)) return SampleRef::adopt(d);
+  }
+  auto* d = new SampleData;
+  d->encoding_ = encoding; d->channels_ = channelCount; d->frames_ = frames; d->sr_ = sr; d->hash_ = hash; d->pool_ = this;
+  auto& data = *stored(d);
+  data.assign((size_t)channelCount * (frames + 1), T{});
+  for (int c = 0; c < channelCount; ++c) std::memcpy(data.data() + (size_t)c * (frames + 1), channels[c], frames * sizeof(T));
+  byHash_.emplace(hash, d);
+  bytes_ += d->bytes();
+  return SampleRef(d);
+}
+SampleRef SamplePool::intern(const float* const* channels, int channelCount, uint64_t frames, double sr){
+  return intern(SampleEncoding::Float32, channels, channelCount, frames, sr);
+}
+SampleRef SamplePool::intern(const int16_t* const* channels, int channelCount, uint64_t frames, double sr){
+  return intern(SampleEncoding::Int16, channels, channelCount, frames, sr);
+}
+SampleRef SamplePool::load(const std::string& path, SampleEncoding encoding, std::string& err, int maxChannels){
+  MappedWav wav;
+  if (!wav.open(path, err)) return {};
+  const WavInfo& info = wav.info();
+  const int channels = std::max(1, std::min(info.channels, maxChannels));
+  std::vector<float> planar((size_t)channels * info.frames);
+  constexpr uint32_t kChunk = 65536;
+  std::vector<float*> out((size_t)channels);
+  for (uint64_t first = 0; first < info.frames; first += kChunk){
+    for (int c = 0; c < channels; ++c) out[(size_t)c] = planar.data() + (size_t)c * info.frames + first;
+    wav.decode(first, (uint32_t)std::min<uint64_t>(kChunk, info.frames - first), out.data(), channels);
+  }
+  if (encoding == SampleEncoding::Float32){
+    std::vector<const float*> in((size_t)channels);
+    for (int c = 0; c < channels; ++c) in[(size_t)c] = planar.data() + (size_t)c * info.frames;
+    return intern(in.data(), channels, info.frames, info.sr);
+  }
+  std::vector<int16_t> pcm(planar.size());
+  for (size_t i = 0; i < planar.size(); ++i) pcm[i] = (int16_t)std::lrint(std::clamp(planar[i] * 32768.0f, -32768.0f, 32767.0f));
+  std::vector<const int16_t*> in((size_t)channels);
+  for (int c = 0; c < channels; ++c) in[(size_t)c] = pcm.data() + (size_t)c * info.frames;
+  return intern(in.data(), channels, info.frames, info.sr);
+}
+SampleRef SamplePool::intern(const std::vector<std::vector<float>>& channels, double sr){
+  uint64_t frames = 0;
+  for (const auto& c : channels) frames = std::max<uint64_t>(frames, c.size());
+  std::vector<std::vector<float>> padded;
+  std::vector<const float*> ptrs;
+  for (const auto& c : channels){
+    if (c.size() == frames){ ptrs.push_back(c.data()); continue; }
+    padded.emplace_back(c); padded.back().resize(frames, 0.0f); // shorter channels end in silence
+    ptrs.push_back(padded.back().data());
+  }
+  return intern(ptrs.data(), (int)ptrs.size(), frames, sr);
+}
+bool SamplePool::FileKey::operator<(const FileKey& o) const{
+  return std::tie(dev, ino, size, mtime, head) < std::tie(o.dev, o.ino, o.size, o.mtime, o.head);
+}
+std::shared_ptr<const StreamedSample> SamplePool::stream(const std::string& path, std::string& err, uint32_t headFrames){
+  struct stat st{};
+  if (::stat(path.c_str(), &st) != 0){ err = "cannot open " + path; return nullptr; }
+  const FileKey key{(uint64_t)st.st_dev, (uint64_t)st.st_ino, (uint64_t)st.st_size, (int64_t)st.st_mtime, headFrames};
+  {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (auto it = streams_.find(key); it != streams_.end()){
+      if (auto s = it->second.lock()) return s;
+    }
+  }
+  // Opened outside the lock so loader threads open different files in parallel; if two
+  // threads open the same file at once, the first to register it wins.
+  auto s = StreamedSample::open(path, err, headFrames);
+  if (!s) return nullptr;
+  std::lock_guard<std::mutex> lk(mu_);
+  if (auto it = streams_.find(key); it != streams_.end()){
+    if (auto other = it->second.lock()) return other;
+  }
+  for (auto it = streams_.begin(); it != streams_.end();) it = it->second.expired() ? streams_.erase(it) : std::next(it);
+  streams_[key] = s;
+  return s;
+}
+size_t SamplePool::entries() const{
+  std::lock_guard<std::mutex> lk(mu_);
+  return byHash_.size();
+}
+size_t SamplePool::bytes() const{
+  std::lock_guard<std::mutex> lk(mu_);
+  return bytes_;
+}
+} // namespace
@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SampleStreamer.h"
+namespace mydaw::sample {
+class SamplePool;
+// How pooled audio is stored: float, or 16-bit integers at half the memory (full scale 32768).
+enum class SampleEncoding : uint8_t{ Float32, Int16 };
+// Immutable decoded audio owned by a SamplePool: planar channels, each followed by one zero
+// guard frame so interpolating readers may touch frame frames().
+class SampleData{
+  friend class SamplePool; friend class SampleRef;
+  std::vector<float> data_;      // Float32
+  std::vector<int16_t> pcm16_;   // Int16
+  SampleEncoding encoding_{SampleEncoding::Float32};
+  int channels_{0};
+  uint64_t frames_{0};
+  double sr_{0};
+  uint64_t hash_{0};
+  std::atomic<uint32_t> refs_{0};     // zero is final: the entry is on its way to collect()
+  SampleData* nextDead_{nullptr};
+  SamplePool* pool_{nullptr};
+public:
+  int channels() const { return channels_; }
+  uint64_t frames() const { return frames_; }
+  double sampleRate() const { return sr_; }
+  uint64_t hash() const { return hash_; }
+  SampleEncoding encoding() const { return encoding_; }
+  const float* channel(int c) const { return data_.data() + (size_t)c * (frames_ + 1); }     // Float32
+  const int16_t* channel16(int c) const { return pcm16_.data() + (size_t)c * (frames_ + 1); } // Int16
+  size_t bytes() const { return data_.size() * sizeof(float) + pcm16_.size() * sizeof(int16_t); }
+};
+// Counted reference to pooled audio. Copying and dropping it only touch atomics, so either may
+// happen on the audio thread; the memory of unreferenced audio is freed later by collect().
+class SampleRef{
+  SampleData* d_{nullptr};
+  void retain() const { if (d_) d_->refs_.fetch_add(1, std::memory_order_relaxed); }
+  void release();
+  friend class SamplePool;
+  explicit SampleRef(SampleData* d): d_(d) { retain(); }
+  static SampleRef adopt(SampleData* d){ SampleRef r; r.d_ = d; return r; } // d's count already taken
+public:
+  SampleRef()=default;
+  ~SampleRef(){ release(); }
+  SampleRef(const SampleRef& o): d_(o.d_) { retain(); }
+  SampleRef(SampleRef&& o) noexcept: d_(o.d_) { o.d_ = nullptr; }
+  SampleRef& operator=(SampleRef o) noexcept { std::swap(d_, o.d_); return *this; }
+  const SampleData* get() const { return d_; }
+  const SampleData* operator->() const { return d_; }
+  const SampleData& operator*() const { return *d_; }
+  explicit operator bool() const { return d_ != nullptr; }
+  bool operator==(const SampleRef& o) const { return d_ == o.d_; }
+};
+// Process-wide store of sample audio, so RAM grows with unique audio rather than with the
+// number of instances that load it. Decoded audio is keyed by a hash of its content (rate,
+// channels and samples; hash hits are confirmed byte for byte). Streamed files are shared by
+// file identity: their mapped pages already live once in the page cache, and hashing a whole
+// multi-gigabyte file on open would defeat streaming.
+class SamplePool{
+  friend class SampleRef;
+  struct FileKey{
+    uint64_t dev, ino, size; int64_t mtime; uint32_t head;
+    bool operator<(const FileKey& o) const;
+  };
+  mutable std::mutex mu_;
+  std::unordered_multimap<uint64_t, SampleData*> byHash_;
+  std::map<FileKey, std::weak_ptr<const StreamedSample>> streams_;
+  std::atomic<SampleData*> dead_{nullptr};   // lock-free stack of entries whose refs hit zero, each pushed once
+  size_t bytes_{0};
+  void retire(SampleData* d);
+  template<class T> SampleRef intern(SampleEncoding encoding, const T* const* channels, int channelCount, uint64_t frames, double sr);
+public:
+  SamplePool()=default;
+  ~SamplePool();
+  SamplePool(const SamplePool&)=delete;
+  SamplePool& operator=(const SamplePool&)=delete;
+  static SamplePool& shared();
+  // Returns the pooled copy of this audio, adding it if no identical audio is pooled yet.
+  SampleRef intern(const float* const* channels, int channelCount, uint64_t frames, double sr);
+  SampleRef intern(const std::vector<std::vector<float>>& channels, double sr);
+  SampleRef intern(const int16_t* const* channels, int channelCount, uint64_t frames, double sr);
+  // Decodes a whole WAV file into the pool, keeping at most maxChannels channels. Int16 rounds
+  // and clips other formats. Null with err set when the file cannot be read. Blocks on I/O.
+  SampleRef load(const std::string& path, SampleEncoding encoding, std::string& err, int maxChannels = StreamedSample::kMaxChannels);
+  // A StreamedSample for path, shared with everyone else streaming the same file.
+  std::shared_ptr<const StreamedSample> stream(const std::string& path, std::string& err, uint32_t headFrames = StreamedSample::kDefaultHeadFrames);
+  // Frees audio nobody references any more. Never call it on the audio thread.
+  void collect();
+  size_t entries() const;
+  size_t bytes() const;
+};
+// 64-bit hash of a byte range.
+uint64_t hash_bytes(const void* data, size_t len, uint64_t seed);
+} // namespace
@@ -0,0 +1,114 @@
+#include "SampleStreamer.h"
+#include <algorithm>
+#include <cstring>
+namespace mydaw::sample {
+std::shared_ptr<const StreamedSample> StreamedSample::open(const std::string& path, std::string& err, uint32_t headFrames){
+  auto s = std::make_shared<StreamedSample>();
+  if (!s->wav_.open(path, err)) return nullptr;
+  s->channels_ = std::min(s->wav_.info().channels, kMaxChannels);
+  s->headFrames_ = (uint32_t)std::min<uint64_t>(headFrames, s->frames());
+  s->head_.resize((size_t)s->channels_ * s->headFrames_);
+  float* out[kMaxChannels] = {};
+  for (int c = 0; c < s->channels_; ++c) out[c] = s->head_.data() + (size_t)c * s->headFrames_;
+  s->wav_.decode(0, s->headFrames_, out, s->channels_);
+  return s;
+}
+SampleStreamer::SampleStreamer(int streams, uint32_t ringFrames): streams_((size_t)std::max(streams, 1)), ringFrames_(std::max<uint32_t>(ringFrames, 256)) {
+  for (auto& s : streams_) s.ring.assign((size_t)StreamedSample::kMaxChannels * ringFrames_, 0.0f);
+  io_ = std::thread([this]{ run(); });
+}
+SampleStreamer::~SampleStreamer(){
+  stop_.store(true, std::memory_order_release);
+  wake();
+  io_.join();
+}
+SampleStreamer& SampleStreamer::shared(){
+  static SampleStreamer instance;
+  return instance;
+}
+int SampleStreamer::open(const std::shared_ptr<const StreamedSample>& sample){
+  if (!sample || sample->frames() <= sample->headFrames()) return -1; // all in the head
+  for (size_t i = 0; i < streams_.size(); ++i){
+    Stream& s = streams_[i];
+    int expected = Free;
+    if (s.state.load(std::memory_order_relaxed) != Free || !s.state.compare_exchange_strong(expected, Opening, std::memory_order_acquire)) continue;
+    s.sample = sample; // the slot held null, so nothing is released here
+    s.written.store(sample->headFrames(), std::memory_order_relaxed);
+    s.consumed.store(sample->headFrames(), std::memory_order_relaxed);
+    s.state.store(Active, std::memory_order_release);
+    wake();
+    return (int)i;
+  }
+  return -1;
+}
+void SampleStreamer::close(int stream){
+  if (stream < 0) return;
+  streams_[(size_t)stream].state.store(Closing, std::memory_order_release);
+  wake();
+}
+uint32_t SampleStreamer::read(int stream, const StreamedSample& sample, uint64_t frame, uint32_t n, float* const* out){
+  const int channels = sample.channels();
+  if (frame >= sample.frames()) return 0;
+  n = (uint32_t)std::min<uint64_t>(n, sample.frames() - frame);
+  uint32_t done = 0;
+  if (frame < sample.headFrames()){
+    done = (uint32_t)std::min<uint64_t>(n, sample.headFrames() - frame);
+    for (int c = 0; c < channels; ++c) std::memcpy(out[c], sample.head(c) + frame, sizeof(float) * done);
+  }
+  if (done == n) return n;
+  uint32_t have = 0;
+  if (stream >= 0){
+    Stream& s = streams_[(size_t)stream];
+    const uint64_t from = frame + done;
+    s.consumed.store(from, std::memory_order_release);
+    const uint64_t written = s.written.load(std::memory_order_acquire);
+    have = written > from ? (uint32_t)std::min<uint64_t>(n - done, written - from) : 0;
+    for (uint32_t k = 0; k < have;){
+      const uint32_t at = (uint32_t)((from + k) % ringFrames_);
+      const uint32_t run = std::min(have - k, ringFrames_ - at);
+      for (int c = 0; c < channels; ++c) std::memcpy(out[c] + done + k, s.ring.data() + (size_t)c * ringFrames_ + at, sizeof(float) * run);
+      k += run;
+    }
+    if (written < sample.frames() && written - std::min(written, from + have) < ringFrames_ / 2) wake();
+  }
+  if (done + have < n){
+    underruns_.fetch_add(1, std::memory_order_relaxed);
+    for (int c = 0; c < channels; ++c) std::fill(out[c] + done + have, out[c] + n, 0.0f);
+  }
+  return n;
+}
+// Tops up one stream's ring; true when it decoded anything.
+bool SampleStreamer::fill(Stream& s){
+  const StreamedSample& sample = *s.sample;
+  const uint64_t consumed = s.consumed.load(std::memory_order_acquire);
+  uint64_t written = std::max(s.written.load(std::memory_order_relaxed), consumed); // the reader skipped ahead
+  const uint64_t end = std::min(sample.frames(), consumed + ringFrames_);
+  if (written >= end) return false;
+  sample.wav().prefetch(end, ringFrames_); // the next top-up
+  float* out[StreamedSample::kMaxChannels] = {};
+  while (written < end){
+    const uint32_t at = (uint32_t)(written % ringFrames_);
+    const uint32_t run = (uint32_t)std::min<uint64_t>(end - written, ringFrames_ - at);
+    for (int c = 0; c < sample.channels(); ++c) out[c] = s.ring.data() + (size_t)c * ringFrames_ + at;
+    sample.wav().decode(written, run, out, sample.channels());
+    written += run;
+  }
+  s.written.store(written, std::memory_order_release);
+  return true;
+}
+void SampleStreamer::run(){
+  while (!stop_.load(std::memory_order_acquire)){
+    const uint32_t seen = kick_.load(std::memory_order_acquire);
+    bool worked = false;
+    for (auto& s : streams_){
+      const int state = s.state.load(std::memory_order_acquire);
+      if (state == Closing){ s.sample.reset(); s.state.store(Free, std::memory_order_release); }
+      else if (state == Active) worked |= fill(s);
+    }
+    if (worked) continue;
+    sleeping_.store(true);
+    kick_.wait(seen); // returns at once if a wake() came since `seen`
+    sleeping_.store(false);
+  }
+}
+} // namespace
@@ -0,0 +1,75 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MappedWav.h"
+namespace mydaw::sample {
+// A WAV file played from disk. Its first headFrames are decoded into memory when it is opened,
+// so a voice can start on the spot; SampleStreamer reads the rest ahead into per-voice rings.
+// At most kMaxChannels channels are kept.
+class StreamedSample{
+  MappedWav wav_;
+  std::vector<float> head_;
+  uint32_t headFrames_{0};
+  int channels_{0};
+public:
+  static constexpr int kMaxChannels = 2;
+  static constexpr uint32_t kDefaultHeadFrames = 16384;
+  // Null with err set when the file cannot be mapped or is not a supported WAV.
+  static std::shared_ptr<const StreamedSample> open(const std::string& path, std::string& err, uint32_t headFrames = kDefaultHeadFrames);
+  int channels() const { return channels_; }
+  uint64_t frames() const { return wav_.info().frames; }
+  double sampleRate() const { return wav_.info().sr; }
+  uint32_t headFrames() const { return headFrames_; }
+  const float* head(int c) const { return head_.data() + (size_t)c * headFrames_; }
+  const MappedWav& wav() const { return wav_; }
+};
+// Background read-ahead for StreamedSamples. A fixed set of streams, each with its own ring of
+// ringFrames per channel, is allocated up front; one I/O thread decodes from the mapped files
+// into the rings of open streams. The audio-thread calls (open/read/close) never lock, block or
+// allocate: data not read ahead yet comes back as silence and counts as an underrun.
+class SampleStreamer{
+  enum State : int{ Free, Opening, Active, Closing };
+  struct Stream{
+    std::atomic<int> state{Free};
+    std::shared_ptr<const StreamedSample> sample; // set by open(), dropped by the I/O thread
+    std::vector<float> ring;                      // kMaxChannels x ringFrames
+    alignas(64) std::atomic<uint64_t> written{0}; // frames up to here are in the ring (I/O thread)
+    alignas(64) std::atomic<uint64_t> consumed{0};// frames before here may be overwritten (reader)
+  };
+  std::vector<Stream> streams_;
+  uint32_t ringFrames_;
+  std::atomic<uint32_t> kick_{0};
+  std::atomic<bool> sleeping_{false}; // the I/O thread is (about to be) parked on kick_
+  std::atomic<bool> stop_{false};
+  std::atomic<uint64_t> underruns_{0};
+  std::thread io_;
+  void run();
+  bool fill(Stream& s);
+  // The notify is a syscall, so it is made only when the I/O thread may be parked. Both sides
+  // are seq_cst: either run() sees the new kick_ or the waker sees sleeping_.
+  void wake(){ kick_.fetch_add(1); if (sleeping_.load()) kick_.notify_one(); }
+public:
+  static constexpr int kDefaultStreams = 128;
+  static constexpr uint32_t kDefaultRingFrames = 8192;
+  explicit SampleStreamer(int streams = kDefaultStreams, uint32_t ringFrames = kDefaultRingFrames);
+  ~SampleStreamer();
+  SampleStreamer(const SampleStreamer&)=delete;
+  SampleStreamer& operator=(const SampleStreamer&)=delete;
+  // Process-wide instance with the default streams and ring, created on first call; make that
+  // call off the audio thread.
+  static SampleStreamer& shared();
+  // Audio thread. open() returns a stream id, or -1 when all are busy (the head still plays).
+  int open(const std::shared_ptr<const StreamedSample>& sample);
+  // Copies frames [frame, frame+n) of the sample into out[0..channels) and returns how many
+  // exist (n, or fewer at the end). Reads must move forward: frames before `frame` are released
+  // for reuse. n may not exceed ringFrames()/2.
+  uint32_t read(int stream, const StreamedSample& sample, uint64_t frame, uint32_t n, float* const* out);
+  void close(int stream);
+  uint32_t ringFrames() const { return ringFrames_; }
+  uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+};
+} // namespace
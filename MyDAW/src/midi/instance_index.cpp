@@ -0,0 +1,44 @@
+#include "midi/instance_index.hpp"
+#include "midi/scheduler.hpp"
+#include <algorithm>
+namespace mydaw::midi {
+namespace {
+Tick sat_add(Tick a, Tick b){ return (b == PatternTimeline::kNever || a > PatternTimeline::kNever - b) ? PatternTimeline::kNever : a + b; }
+} // namespace
+InstanceIndex::InstanceIndex(const std::vector<PatternInstance>& instances){
+  items_.reserve(instances.size());
+  for (const auto& inst : instances){
+    if (!inst.pattern || !inst.enabled) continue;
+    auto tl = inst.timeline ? inst.timeline : PatternTimeline::compile(*inst.pattern);
+    if (tl->empty()) continue;
+    // Same loop rule as Scheduler::gather_realtime.
+    const Tick loopLen = inst.loopLengthTicks > 0 ? inst.loopLengthTicks : inst.pattern->length;
+    const Tick ls = tl->last_start(loopLen);
+    items_.push_back(Item{inst.startTick + tl->first_tick(), sat_add(inst.startTick, tl->end_tick(loopLen)),
+                          sat_add(inst.startTick, ls), inst.startTick, loopLen, std::move(tl)});
+    lastStart_ = std::max(lastStart_, items_.back().lastStart);
+  }
+  std::sort(items_.begin(), items_.end(), [](const Item& a, const Item& b){ return a.beg < b.beg; });
+  maxEnd_.resize(items_.size());
+  build_max(0, items_.size());
+}
+Tick InstanceIndex::build_max(size_t lo, size_t hi){
+  if (lo >= hi) return std::numeric_limits<Tick>::min();
+  const size_t mid = lo + (hi - lo)/2;
+  return maxEnd_[mid] = std::max({items_[mid].end, build_max(lo, mid), build_max(mid + 1, hi)});
+}
+Tick InstanceIndex::next_start_after(Tick tick, Tick horizon) const{
+  Tick best = PatternTimeline::kNever;
+  auto f = [&](const Item& it){
+    const Tick rel = it.tl->next_start_after(tick - it.startTick, it.loopLen);
+    if (rel != PatternTimeline::kNever) best = std::min(best, it.startTick + rel);
+    return false;
+  };
+  if (horizon > tick) visit(tick + 1, horizon, f, 0, items_.size());
+  return best;
+}
+bool InstanceIndex::any_note_in(Tick startTick, Tick endTick) const{
+  auto f = [&](const Item& it){ return it.tl->any_note_in(startTick - it.startTick, endTick - it.startTick, it.loopLen); };
+  return endTick > startTick && visit(startTick, endTick, f, 0, items_.size());
+}
+} // namespace
@@ -1,62 +1,96 @@
 #include "midi/scheduler.hpp"
+#include "dsp/CounterRng.h"
 #include <algorithm>
 #include <cmath>
+#include <unordered_map>
 namespace mydaw::midi {
-void Scheduler::gather(const Pattern& pat, Tick clipStartTick, Tick loopLenTick, int64_t blockSample, uint32_t frames, std::vector<Ev>& out) const{
-  const Tick blkBeg = tb_.samples_to_ticks(blockSample);
-  const Tick blkEnd = tb_.samples_to_ticks(blockSample + frames);
-  for (const auto& ch : pat.channels){
-    if (ch.gen==0) continue;
-    for (const auto& note : ch.notes){
-      const Tick patternLength = pat.length; if (patternLength<=0) continue;
-      const Tick searchStart = std::max<Tick>(0, blkBeg - patternLength);
-      const Tick searchEnd = blkEnd + patternLength;
-      for (Tick loopOffset = 0; loopOffset <= searchEnd; loopOffset += patternLength){
-        const Tick absoluteStart = clipStartTick + loopOffset + note.start;
-        const Tick absoluteEnd = absoluteStart + note.len;
-        if (absoluteStart >= searchEnd || absoluteEnd <= searchStart) continue;
-        if (loopLenTick > 0 && loopOffset >= loopLenTick) break;
-        if (absoluteStart >= blkBeg && absoluteStart < blkEnd){
-          const int64_t sp = tb_.tick_to_samples(absoluteStart);
-          const uint32_t off = (uint32_t)std::clamp<int64_t>(sp - blockSample, 0LL, (int64_t)frames - 1);
-          Ev e{ch.gen, EvType::NoteOn, off, note.pitch, note.vel, 0}; out.push_back(e);
-        }
-        if (absoluteEnd >= blkBeg && absoluteEnd < blkEnd){
-          const int64_t sp = tb_.tick_to_samples(absoluteEnd);
-          const uint32_t off = (uint32_t)std::clamp<int64_t>(sp - blockSample, 0LL, (int64_t)frames - 1);
-          Ev e{ch.gen, EvType::NoteOff, off, note.pitch, note.rel, 0}; out.push_back(e);
-        }
-        if (note.slide && note.fine!=0){
-          const Tick bendStart = std::max<Tick>(absoluteStart, blkBeg);
-          const Tick bendEnd = std::min<Tick>(absoluteEnd, blkEnd);
-          for (Tick t=bendStart; t<bendEnd; t += tb_.samples_to_ticks(64)){
-            const int64_t sp = tb_.tick_to_samples(t);
-            const uint32_t off = (uint32_t)std::clamp<int64_t>(sp - blockSample, 0LL, (int64_t)frames - 1);
-            const float progress = (float)(t - absoluteStart) / (float)note.len;
-            const int bend = (int)(note.fine * progress * 64);
-            Ev e{ch.gen, EvType::PitchBend, off, note.pitch, 0, std::clamp(bend, -8192, 8191)}; out.push_back(e);
-          }
-        }
-      }
-    }
+void Scheduler::compile_timelines(std::vector<PatternInstance>& instances){
+  std::unordered_map<const Pattern*, std::vector<std::shared_ptr<const PatternTimeline>>> cache;
+  for (auto& inst : instances){
+    if (!inst.pattern){ inst.timeline.reset(); continue; }
+    auto& shared = cache[inst.pattern];
+    if (inst.timeline && inst.timeline->compiled_from(*inst.pattern, inst.transform)){ shared.push_back(inst.timeline); continue; }
+    auto it = std::find_if(shared.begin(), shared.end(), [&](const auto& tl){ return tl->compiled_from(*inst.pattern, inst.transform); });
+    if (it != shared.end()){ inst.timeline = *it; continue; }
+    inst.timeline = PatternTimeline::compile(*inst.pattern, inst.transform);
+    shared.push_back(inst.timeline);
   }
-  std::sort(out.begin(), out.end(), [](const Ev& a, const Ev& b){
-    if (a.sampOff != b.sampOff) return a.sampOff < b.sampOff;
-    if (a.type != b.type) return a.type == EvType::NoteOff;
-    return false;
+}
+namespace {
+// Walks one timeline over a block. onEvent(ev) receives note events in tick order, then
+// onBreak() is called once and onEvent receives one PitchRamp per slide starting in the block.
+template<class F, class G>
+void emit_block(const TimeBase& tb, const PatternTimeline& tl, Tick clipStartTick, Tick loopLenTick, int64_t blockSample, uint32_t frames, F&& onEvent, G&& onBreak){
+  if (tl.length()<=0 || frames==0) return;
+  const Tick blkBeg = tb.samples_to_ticks(blockSample);
+  const Tick blkEnd = tb.samples_to_ticks(blockSample + frames);
+  auto offset_of = [&](int64_t sp){ return (uint32_t)std::clamp<int64_t>(sp - blockSample, 0LL, (int64_t)frames - 1); };
+  tl.for_each_event(blkBeg - clipStartTick, blkEnd - clipStartTick, loopLenTick, [&](const TimelineEv& e, Tick rel){
+    onEvent(Ev::note(e.type, offset_of(tb.tick_to_samples(clipStartTick + rel)), e.gen, e.pitch, e.vel));
   });
+  onBreak();
+  tl.for_each_slide(blkBeg - clipStartTick, blkEnd - clipStartTick, loopLenTick, [&](const TimelineSlide& s, Tick rel){
+    const Tick absoluteStart = clipStartTick + rel;
+    const int64_t sp = tb.tick_to_samples(absoluteStart);
+    const int64_t ep = tb.tick_to_samples(absoluteStart + s.len);
+    onEvent(Ev::bend_ramp(offset_of(sp), s.gen, s.pitch, 0, s.fine * 64, (uint32_t)std::max<int64_t>(ep - sp, 0)));
+  });
+}
+// Insertion sort: linear on the already tick-ordered runs, and allocation-free.
+void sort_run(Ev* b, Ev* e){
+  for (Ev* i = b + 1; i < e; ++i){
+    Ev v = *i; Ev* j = i;
+    for (; j > b && ev_before(v, *(j-1)); --j) *j = *(j-1);
+    *j = v;
+  }
+}
+bool same_event(const Ev& a, const Ev& b){
+  return a.gen==b.gen && a.type==b.type && a.sampOff==b.sampOff && a.pitch==b.pitch && a.vel==b.vel;
+}
+} // namespace
+void Scheduler::gather(const PatternTimeline& tl, Tick clipStartTick, Tick loopLenTick, int64_t blockSample, uint32_t frames, std::vector<Ev>& out) const{
+  const size_t first = out.size();
+  emit_block(tb_, tl, clipStartTick, loopLenTick, blockSample, frames, [&](const Ev& e){ out.push_back(e); }, []{});
+  std::stable_sort(out.begin() + (std::ptrdiff_t)first, out.end(), ev_before);
+}
+void Scheduler::gather(const Pattern& pat, Tick clipStartTick, Tick loopLenTick, int64_t blockSample, uint32_t frames, std::vector<Ev>& out) const{
+  gather(*PatternTimeline::compile(pat), clipStartTick, loopLenTick, blockSample, frames, out);
 }
-void Scheduler::gather_realtime(const std::vector<PatternInstance>& instances, int64_t blockSample, uint32_t frames, std::vector<Ev>& out) const{
-  out.clear();
+void Scheduler::reserve(size_t maxEvents, size_t maxRuns){
+  staging_.reserve(maxEvents);
+  runs_.clear(); runs_.reserve(maxRuns);
+  heap_.clear(); heap_.reserve(maxRuns);
+}
+void Scheduler::gather_realtime(const std::vector<PatternInstance>& instances, int64_t blockSample, uint32_t frames, EventLanes& out) const{
+  out.clear(); staging_.clear(); runs_.clear(); heap_.clear();
+  uint32_t runBeg = 0;
+  auto close_run = [&]{
+    const uint32_t runEnd = (uint32_t)staging_.size();
+    if (runEnd == runBeg) return;
+    if (runs_.size() == runs_.capacity()){ out.count_dropped(runEnd - runBeg); staging_.truncate(runBeg); return; }
+    sort_run(staging_.begin() + runBeg, staging_.begin() + runEnd);
+    runs_.push_back(Run{runBeg, runEnd});
+    runBeg = runEnd;
+  };
+  auto push = [&](const Ev& e){ if (!staging_.push(e)) out.count_dropped(1); };
   for (const auto& inst : instances){
-    if (!inst.pattern || !inst.enabled) continue;
+    if (!inst.pattern || !inst.enabled || !inst.timeline) continue;
     const Tick loopLen = inst.loopLengthTicks > 0 ? inst.loopLengthTicks : inst.pattern->length;
-    gather(*inst.pattern, inst.startTick, loopLen, blockSample, frames, out);
+    emit_block(tb_, *inst.timeline, inst.startTick, loopLen, blockSample, frames, push, close_run);
+    close_run();
+  }
+  // k-way merge; heap_ holds run indices as a min-heap on each run's head event.
+  auto later = [&](uint32_t a, uint32_t b){ return ev_before(staging_[runs_[b].beg], staging_[runs_[a].beg]); };
+  for (uint32_t r = 0; r < (uint32_t)runs_.size(); ++r) heap_.push_back(r);
+  std::make_heap(heap_.begin(), heap_.end(), later);
+  while (!heap_.empty()){
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    Run& run = runs_[heap_.back()];
+    const Ev& e = staging_[run.beg++];
+    if (out.empty() || !same_event(out.back(), e)) out.push(e);
+    if (run.beg == run.end) heap_.pop_back();
+    else std::push_heap(heap_.begin(), heap_.end(), later);
   }
-  auto last = std::unique(out.begin(), out.end(), [](const Ev& a, const Ev& b){
-    return a.gen==b.gen && a.type==b.type && a.sampOff==b.sampOff && a.pitch==b.pitch && a.vel==b.vel;
-  });
-  out.erase(last, out.end());
 }
 void Scheduler::apply_swing(std::vector<Ev>& events, float swingPercent, Tick swingResolution) const{
   if (swingPercent <= 50.0f || swingResolution <= 0) return;
@@ -77,18 +111,17 @@ void Scheduler::apply_swing(std::vector<Ev>& events, float swingPercent, Tick sw
   }
   std::sort(events.begin(), events.end(), [](const Ev& a, const Ev& b){ return a.sampOff < b.sampOff; });
 }
-void Scheduler::apply_humanize(std::vector<Ev>& events, float timingVariation, float velocityVariation) const{
-  static thread_local std::mt19937 rng(std::random_device{}());
+void Scheduler::apply_humanize(std::vector<Ev>& events, float timingVariation, float velocityVariation, uint64_t seed, int64_t blockSample) const{
   const float maxTiming = timingVariation * (float)tb_.tick_to_samples(kPPQ/16);
   const float maxVelVar = velocityVariation * 127.0f;
-  std::uniform_real_distribution<float> td(-maxTiming, maxTiming);
-  std::uniform_real_distribution<float> vd(-maxVelVar, maxVelVar);
   for (auto& ev : events){
     if (ev.type == EvType::NoteOn){
-      const float dt = td(rng);
+      const uint64_t key = ((uint64_t)ev.gen << 8) | ev.pitch;
+      const uint64_t at = (uint64_t)(blockSample + ev.sampOff);
+      const float dt = dsp::CounterRng::bipolar(dsp::CounterRng::hash(seed, key, at, 0)) * maxTiming;
       int32_t newOff = (int32_t)((float)ev.sampOff + dt);
       ev.sampOff = (uint32_t)std::max(0, newOff);
-      const float dv = vd(rng);
+      const float dv = dsp::CounterRng::bipolar(dsp::CounterRng::hash(seed, key, at, 1)) * maxVelVar;
       int nv = (int)ev.vel + (int)dv;
       ev.vel = (uint8_t)std::clamp(nv, 1, 127);
     }
@@ -107,30 +140,18 @@ void Scheduler::quantize_events(std::vector<Ev>& events, Tick quantizeGrid) cons
   }
   std::sort(events.begin(), events.end(), [](const Ev& a, const Ev& b){ return a.sampOff < b.sampOff; });
 }
+Tick Scheduler::get_next_event_tick(const InstanceIndex& index, Tick currentTick) const{
+  if (!index.has_start_after(currentTick)) return currentTick + kPPQ;
+  const Tick horizon = currentTick + kPPQ*4;
+  return std::min(horizon, index.next_start_after(currentTick, horizon + 1));
+}
+bool Scheduler::has_events_in_range(const InstanceIndex& index, Tick startTick, Tick endTick) const{
+  return index.any_note_in(startTick, endTick);
+}
 Tick Scheduler::get_next_event_tick(const std::vector<PatternInstance>& instances, Tick currentTick) const{
-  Tick nextTick = currentTick + kPPQ*4; bool found=false;
-  for (const auto& inst : instances){
-    if (!inst.pattern || !inst.enabled) continue;
-    for (const auto& ch : inst.pattern->channels){
-      for (const auto& note : ch.notes){
-        const Tick abs = inst.startTick + note.start;
-        if (abs > currentTick){ nextTick = std::min(nextTick, abs); found=true; }
-      }
-    }
-  }
-  return found ? nextTick : currentTick + kPPQ;
+  return get_next_event_tick(InstanceIndex(instances), currentTick);
 }
 bool Scheduler::has_events_in_range(const std::vector<PatternInstance>& instances, Tick startTick, Tick endTick) const{
-  for (const auto& inst : instances){
-    if (!inst.pattern || !inst.enabled) continue;
-    for (const auto& ch : inst.pattern->channels){
-      for (const auto& note : ch.notes){
-        const Tick a = inst.startTick + note.start;
-        const Tick b = a + note.len;
-        if (a < endTick && b > startTick) return true;
-      }
-    }
-  }
-  return false;
+  return has_events_in_range(InstanceIndex(instances), startTick, endTick);
 }
 } // namespace
@@ -0,0 +1,107 @@
+#include "midi/timeline.hpp"
+#include "dsp/CounterRng.h"
+namespace mydaw::midi {
+namespace {
+// Returns the transformed start tick of note `index`; may adjust its velocity.
+Tick transform_note(const EventTransform& xf, uint64_t index, Tick start, uint8_t& vel){
+  if (xf.quantizeGrid > 0) start = ((start + xf.quantizeGrid/2) / xf.quantizeGrid) * xf.quantizeGrid;
+  if (xf.swingPercent > 50.0f && xf.swingResolution > 0){
+    const Tick halfRes = xf.swingResolution / 2;
+    const float offset = (xf.swingPercent / 100.0f - 0.5f) * 2.0f;
+    if (start % xf.swingResolution == halfRes) start += (Tick)(halfRes * offset * 0.25f);
+  }
+  if (xf.humanizeTiming != 0.0f){
+    const float dt = dsp::CounterRng::bipolar(dsp::CounterRng::hash(xf.seed, index, 0)) * xf.humanizeTiming * (float)(kPPQ/16);
+    start = std::max<Tick>(0, start + (Tick)dt);
+  }
+  if (xf.humanizeVelocity != 0.0f){
+    const float dv = dsp::CounterRng::bipolar(dsp::CounterRng::hash(xf.seed, index, 1)) * xf.humanizeVelocity * 127.0f;
+    vel = (uint8_t)std::clamp((int)vel + (int)dv, 1, 127);
+  }
+  return start;
+}
+} // namespace
+std::shared_ptr<const PatternTimeline> PatternTimeline::compile(const Pattern& pat, const EventTransform& xf){
+  auto tl = std::make_shared<PatternTimeline>();
+  tl->length_ = pat.length;
+  tl->source_ = &pat; tl->revision_ = pat.revision; tl->transform_ = xf;
+  if (pat.length <= 0) return tl;
+  uint64_t index = 0;
+  auto place = [&](Tick t, uint32_t& wrap){ wrap = (uint32_t)(t / pat.length); tl->maxWrap_ = std::max(tl->maxWrap_, wrap); return t % pat.length; };
+  for (const auto& ch : pat.channels){
+    if (ch.gen==0) continue;
+    for (const auto& note : ch.notes){
+      const uint64_t noteIndex = index++;
+      if (note.start < 0) continue;
+      uint8_t vel = note.vel;
+      const Tick start = transform_note(xf, noteIndex, note.start, vel);
+      TimelineEv on{0, 0, ch.gen, EvType::NoteOn, note.pitch, vel};
+      on.phase = place(start, on.wrap); tl->events_.push_back(on);
+      TimelineEv off{0, 0, ch.gen, EvType::NoteOff, note.pitch, note.rel};
+      off.phase = place(start + std::max<Tick>(note.len, 0), off.wrap); tl->events_.push_back(off);
+      tl->starts_.push_back(start);
+      tl->spans_.push_back(Span{start, start + std::max<Tick>(note.len, 1)});
+      if (note.slide && note.fine!=0 && note.len > 0){
+        TimelineSlide s{0, 0, note.len, ch.gen, note.pitch, note.fine};
+        s.phase = place(start, s.wrap); tl->slides_.push_back(s);
+      }
+    }
+  }
+  std::stable_sort(tl->events_.begin(), tl->events_.end(), [](const TimelineEv& a, const TimelineEv& b){
+    if (a.phase != b.phase) return a.phase < b.phase;
+    return a.type == EvType::NoteOff && b.type != EvType::NoteOff;
+  });
+  std::stable_sort(tl->slides_.begin(), tl->slides_.end(), [](const TimelineSlide& a, const TimelineSlide& b){ return a.phase < b.phase; });
+  std::sort(tl->starts_.begin(), tl->starts_.end());
+  std::sort(tl->spans_.begin(), tl->spans_.end(), [](const Span& a, const Span& b){ return a.beg < b.beg; });
+  size_t n = 0;
+  for (const auto& sp : tl->spans_){
+    if (n && sp.beg <= tl->spans_[n-1].end) tl->spans_[n-1].end = std::max(tl->spans_[n-1].end, sp.end);
+    else tl->spans_[n++] = sp;
+  }
+  tl->spans_.resize(n);
+  return tl;
+}
+Tick PatternTimeline::end_tick(Tick loopLen) const{
+  const Tick n = loops(length_, loopLen);
+  if (spans_.empty() || n == 0) return first_tick();
+  if (n == kNever) return kNever;
+  return (n-1)*length_ + spans_.back().end;
+}
+Tick PatternTimeline::last_start(Tick loopLen) const{
+  const Tick n = loops(length_, loopLen);
+  if (starts_.empty() || n == 0) return std::numeric_limits<Tick>::min();
+  if (n == kNever) return kNever;
+  return (n-1)*length_ + starts_.back();
+}
+bool PatternTimeline::any_note_in(Tick relBeg, Tick relEnd, Tick loopLen) const{
+  if (spans_.empty() || relEnd <= relBeg) return false;
+  const Tick n = loops(length_, loopLen);
+  const Tick ua = spans_.front().beg, ub = spans_.back().end;
+  const Tick kHi = std::min<Tick>(n - 1, floor_div(relEnd - ua - 1, length_));
+  // Stops at the first iteration lying wholly inside the range, so at most
+  // ceil((ub-ua)/length)+1 iterations are searched.
+  for (Tick k = std::max<Tick>(0, floor_div(relBeg - ub, length_) + 1); k <= kHi; ++k){
+    const Tick base = k*length_;
+    if (base + ua >= relBeg && base + ub <= relEnd) return true;
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), relBeg - base, [](Tick t, const Span& sp){ return t < sp.end; });
+    if (it != spans_.end() && it->beg < relEnd - base) return true;
+  }
+  return false;
+}
+Tick PatternTimeline::next_start_after(Tick rel, Tick loopLen) const{
+  if (starts_.empty()) return kNever;
+  const Tick n = loops(length_, loopLen);
+  const Tick smin = starts_.front(), smax = starts_.back();
+  Tick best = kNever;
+  // Starts past length_ let a later iteration undercut an earlier one, so keep
+  // going until an iteration's first start cannot beat the best found.
+  for (Tick k = std::max<Tick>(0, floor_div(rel - smax, length_)); k < n; ++k){
+    const Tick base = k*length_;
+    if (base + smin >= best) break;
+    auto it = std::upper_bound(starts_.begin(), starts_.end(), rel - base);
+    if (it != starts_.end()) best = std::min(best, base + *it);
+  }
+  return best;
+}
+} // namespace
@@ -0,0 +1,66 @@
+#include "midi/timing.hpp"
+#include <algorithm>
+namespace mydaw::midi {
+namespace {
+constexpr double kMinBpm = 1e-3;
+// Seconds spent moving dt ticks from a segment start at bpm b0 with the given slope.
+double seg_seconds(double b0, double slope, double dt){
+  if (slope == 0.0) return 60.0 * dt / ((double)kPPQ * b0);
+  return 60.0 / (double)kPPQ * std::log((b0 + slope*dt) / b0) / slope;
+}
+double seg_ticks(double b0, double slope, double ds){
+  if (slope == 0.0) return ds * (double)kPPQ * b0 / 60.0;
+  return (b0 * std::exp(ds * (double)kPPQ * slope / 60.0) - b0) / slope;
+}
+} // namespace
+TempoMap::TempoMap(std::vector<TempoPoint> points):points_(std::move(points)){
+  std::stable_sort(points_.begin(), points_.end(), [](const TempoPoint& a, const TempoPoint& b){ return a.tick < b.tick; });
+  if (points_.empty()) points_.push_back(TempoPoint{});
+  if (points_.front().tick != 0) points_.insert(points_.begin(), TempoPoint{0, points_.front().bpm, false});
+  segs_.reserve(points_.size());
+  double sec = 0.0;
+  for (size_t i=0; i<points_.size(); ++i){
+    const auto& p = points_[i];
+    const double b0 = std::max(p.bpm, kMinBpm);
+    double slope = 0.0;
+    if (p.ramp && i+1 < points_.size() && points_[i+1].tick > p.tick)
+      slope = (std::max(points_[i+1].bpm, kMinBpm) - b0) / (double)(points_[i+1].tick - p.tick);
+    if (!segs_.empty()){
+      const auto& prev = segs_.back();
+      sec += seg_seconds(prev.bpm, prev.slope, (double)(p.tick - prev.tick));
+      if (p.tick == prev.tick) segs_.pop_back();
+    }
+    segs_.push_back(Seg{p.tick, b0, slope, sec});
+  }
+}
+size_t TempoMap::find_tick(Tick t, size_t& cursor) const{
+  const size_t n = segs_.size();
+  auto fits = [&](size_t i){ return segs_[i].tick <= t && (i+1 == n || t < segs_[i+1].tick); };
+  if (cursor < n && fits(cursor)) return cursor;
+  if (cursor+1 < n && fits(cursor+1)) return ++cursor;
+  auto it = std::upper_bound(segs_.begin(), segs_.end(), t, [](Tick v, const Seg& s){ return v < s.tick; });
+  return cursor = (it == segs_.begin()) ? 0 : (size_t)(it - segs_.begin()) - 1;
+}
+size_t TempoMap::find_sec(double s, size_t& cursor) const{
+  const size_t n = segs_.size();
+  auto fits = [&](size_t i){ return segs_[i].sec <= s && (i+1 == n || s < segs_[i+1].sec); };
+  if (cursor < n && fits(cursor)) return cursor;
+  if (cursor+1 < n && fits(cursor+1)) return ++cursor;
+  auto it = std::upper_bound(segs_.begin(), segs_.end(), s, [](double v, const Seg& g){ return v < g.sec; });
+  return cursor = (it == segs_.begin()) ? 0 : (size_t)(it - segs_.begin()) - 1;
+}
+double TempoMap::seconds_at(Tick t, size_t& cursor) const{
+  if (t < 0) return seg_seconds(segs_.front().bpm, 0.0, (double)t);
+  const Seg& g = segs_[find_tick(t, cursor)];
+  return g.sec + seg_seconds(g.bpm, g.slope, (double)(t - g.tick));
+}
+double TempoMap::ticks_at(double seconds, size_t& cursor) const{
+  if (seconds < 0.0) return seg_ticks(segs_.front().bpm, 0.0, seconds);
+  const Seg& g = segs_[find_sec(seconds, cursor)];
+  return (double)g.tick + seg_ticks(g.bpm, g.slope, seconds - g.sec);
+}
+double TempoMap::bpm_at(Tick t, size_t& cursor) const{
+  const Seg& g = segs_[find_tick(t, cursor)];
+  return std::max(g.bpm + g.slope * (double)(t - g.tick), kMinBpm);
+}
+} // namespace
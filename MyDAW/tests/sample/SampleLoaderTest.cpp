@@ -0,0 +1,191 @@
+// SampleLoader and SamplePool checks, run by ctest. Configure with -DMYDAW_SANITIZE=thread (or
+// address) to run them under a sanitizer. Exits non-zero if any check fails.
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sample/SampleLoader.h"
+#include "plugins/rhythm_composer/include/RhythmComposer.h"
+using namespace mydaw;
+namespace fs = std::filesystem;
+namespace {
+int failures = 0;
+#define CHECK(cond) do{ if (!(cond)){ std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++failures; } }while(0)
+
+constexpr uint32_t kFrames = 20000;
+int16_t value(uint32_t i, int c){ return (int16_t)(10000.0 * std::sin(0.01 * i + c)); }
+void put(std::FILE* f, uint32_t v, int bytes, bool bigEndian){
+  for (int b = 0; b < bytes; ++b) std::fputc((int)(v >> 8 * (bigEndian ? bytes - 1 - b : b)) & 0xff, f);
+}
+// Stereo 16-bit WAV at 44.1 kHz of value(); frames adds to its length so each file is unique.
+void write_wav(const fs::path& p, uint32_t frames){
+  std::FILE* f = std::fopen(p.c_str(), "wb");
+  std::fputs("RIFF", f); put(f, 36 + frames * 4, 4, false); std::fputs("WAVEfmt ", f);
+  put(f, 16, 4, false); put(f, 1, 2, false); put(f, 2, 2, false); put(f, 44100, 4, false);
+  put(f, 44100 * 4, 4, false); put(f, 4, 2, false); put(f, 16, 2, false);
+  std::fputs("data", f); put(f, frames * 4, 4, false);
+  for (uint32_t i = 0; i < frames; ++i) for (int c = 0; c < 2; ++c) put(f, (uint16_t)value(i, c), 2, false);
+  std::fclose(f);
+}
+// The same audio as AIFF (16-bit) or uncompressed AIFF-C (24-bit, low byte zero).
+void write_aiff(const fs::path& p, uint32_t frames, bool aifc){
+  const int bytes = aifc ? 3 : 2;
+  const uint32_t comm = aifc ? 24 : 18;
+  std::FILE* f = std::fopen(p.c_str(), "wb");
+  std::fputs("FORM", f); put(f, 4 + 8 + comm + 16 + frames * 2 * bytes, 4, true); std::fputs(aifc ? "AIFC" : "AIFF", f);
+  std::fputs("COMM", f); put(f, comm, 4, true); put(f, 2, 2, true); put(f, frames, 4, true); put(f, bytes * 8, 2, true);
+  const uint8_t rate[10] = {0x40, 0x0E, 0xAC, 0x44, 0, 0, 0, 0, 0, 0}; // 44100 as 80-bit extended
+  std::fwrite(rate, 1, sizeof rate, f);
+  if (aifc){ std::fputs("NONE", f); put(f, 0, 2, true); }
+  std::fputs("SSND", f); put(f, 8 + frames * 2 * bytes, 4, true); put(f, 0, 4, true); put(f, 0, 4, true);
+  for (uint32_t i = 0; i < frames; ++i)
+    for (int c = 0; c < 2; ++c) put(f, aifc ? (uint32_t)(uint16_t)value(i, c) << 8 : (uint16_t)value(i, c), bytes, true);
+  std::fclose(f);
+}
+
+// AIFF and AIFF-C decode to exactly the samples of the same WAV, and so share its pool entry.
+void aiff_matches_wav(const fs::path& dir){
+  write_wav(dir / "same.wav", kFrames);
+  write_aiff(dir / "same.aiff", kFrames, false);
+  write_aiff(dir / "same.aifc", kFrames, true);
+  auto& pool = sample::SamplePool::shared();
+  for (auto encoding : {sample::SampleEncoding::Int16, sample::SampleEncoding::Float32}){
+    std::string err;
+    const sample::SampleRef wav = pool.load((dir / "same.wav").string(), encoding, err);
+    CHECK(wav && wav->channels() == 2 && wav->frames() == kFrames && wav->sampleRate() == 44100.0);
+    if (!wav) continue;
+    for (const char* name : {"same.aiff", "same.aifc"}){
+      const sample::SampleRef aiff = pool.load((dir / name).string(), encoding, err);
+      CHECK(aiff && aiff == wav);
+      if (!aiff) continue;
+      int mismatches = 0;
+      for (int c = 0; c < 2; ++c)
+        for (uint32_t i = 0; i < kFrames; ++i)
+          mismatches += encoding == sample::SampleEncoding::Int16 ? aiff->channel16(c)[i] != value(i, c)
+                                                                  : aiff->channel(c)[i] != (float)value(i, c) / 32768.0f;
+      CHECK(mismatches == 0);
+    }
+  }
+}
+
+// Holds a loader's only worker: a LazySample on a FIFO, due now so the worker takes it first,
+// blocks in open() until release() opens the writer end. Everything queued meanwhile is
+// ordered before the worker picks any of it.
+struct Gate{
+  fs::path path;
+  std::shared_ptr<sample::LazySample> sample;
+  Gate(sample::SampleLoader& loader, const fs::path& dir): path(dir / "gate") {
+    ::mkfifo(path.c_str(), 0600);
+    sample = loader.make(path.string());
+    loader.prefetch(sample, sample::kNow);
+  }
+  void release(){ ::close(::open(path.c_str(), O_WRONLY)); } // blocks until the worker is in open()
+};
+
+// One worker: loads run earliest deadline first, equal deadlines in order, and kNow requests
+// (from any thread, the audio thread included) go ahead of everything queued.
+void deadline_order(const fs::path& dir){
+  sample::SampleLoader loader(1);
+  std::vector<std::shared_ptr<sample::LazySample>> s;
+  for (uint32_t i = 0; i < 8; ++i){
+    write_wav(dir / ("order" + std::to_string(i) + ".wav"), kFrames + i);
+    s.push_back(loader.make((dir / ("order" + std::to_string(i) + ".wav")).string()));
+  }
+  Gate gate(loader, dir);
+  std::vector<int> order;
+  for (int i = 0; i < 6; ++i) loader.prefetch(s[(size_t)i], 1000 - (sample::Deadline)(i / 2) * 100, [&order, i](const sample::LazySample&){ order.push_back(i); });
+  std::thread([&]{ s[1]->request(); }).join();          // a queued load brought forward
+  std::thread([&]{ CHECK(!s[7]->get()); }).join();       // a load only the audio thread asked for
+  gate.release();
+  loader.drain();
+  CHECK(gate.sample->failed());
+  CHECK((order == std::vector<int>{1, 4, 5, 2, 3, 0}));
+  CHECK(s[7]->ready() && s[7]->get());
+  CHECK(!s[6]->ready()); // never asked for
+  const auto p = loader.progress();
+  CHECK(p.finished == p.queued && p.failed == 1);
+}
+
+// Callbacks of a load that finished earlier run from the next poll(); a missing file fails.
+void callbacks(const fs::path& dir){
+  sample::SampleLoader loader(2);
+  auto ok = loader.make((dir / "order0.wav").string());
+  auto missing = loader.make((dir / "missing.wav").string());
+  bool ready = false, failed = false;
+  loader.prefetch(ok, sample::kNow, [&](const sample::LazySample& x){ ready = x.ready(); });
+  loader.prefetch(missing, sample::kNow, [&](const sample::LazySample& x){ failed = x.failed(); });
+  loader.drain();
+  CHECK(ready && failed);
+  bool again = false;
+  loader.prefetch(ok, sample::kWhenIdle, [&](const sample::LazySample& x){ again = x.ready(); });
+  CHECK(!again && loader.poll() == 1 && again);
+}
+
+// RhythmComposer's async loads: a later load of the same pad wins, callbacks of a deleted
+// instance never reach it, and the loaded pad plays.
+void stale_callbacks(const fs::path& dir){
+  auto& loader = sample::SampleLoader::shared();
+  plugins::rhythm_composer::RhythmComposer rc;
+  rc.prepare(44100, 256);
+  std::vector<int> results(5, -1);
+  auto record = [&results](int i){ return [&results, i](bool ok){ results[(size_t)i] = ok; }; };
+  rc.loadSampleAsync(0, (dir / "order0.wav").string(), sample::kNow, record(0));
+  rc.loadSampleAsync(0, (dir / "order1.wav").string(), sample::kNow, record(1));
+  rc.loadSampleAsync(1, (dir / "missing.wav").string(), sample::kNow, record(2));
+  rc.loadSampleAsync(2, (dir / "same.aiff").string(), sample::kNow, record(3));
+  {
+    plugins::rhythm_composer::RhythmComposer gone;
+    gone.loadSampleAsync(0, (dir / "order2.wav").string(), sample::kNow, record(4));
+  }
+  loader.drain();
+  CHECK((results == std::vector<int>{0, 1, 0, 1, 0}));
+  float left[256] = {}, right[256] = {};
+  float* out[2] = {left, right};
+  const AudioBlock block{nullptr, out, 256, 44100, 2};
+  CHECK(rc.triggerPad(2, 1.0f));
+  rc.process(block);
+  float energy = 0.0f;
+  for (float v : left) energy += v * v;
+  CHECK(energy > 0.0f);
+}
+
+// Workers load while another thread polls get() and the control thread queues streams.
+void stress(const fs::path& dir){
+  for (int round = 0; round < 10; ++round){
+    sample::SampleLoader loader(4);
+    std::vector<std::shared_ptr<sample::LazySample>> s;
+    for (int i = 0; i < 8; ++i) s.push_back(loader.make((dir / ("order" + std::to_string(i) + ".wav")).string()));
+    std::atomic<bool> run{true};
+    std::thread audio([&]{ while (run.load()) for (auto& x : s) x->get(); });
+    int calls = 0;
+    for (int i = 0; i < 8; i += 2) loader.prefetch(s[(size_t)i], sample::kWhenIdle, [&calls](const sample::LazySample&){ ++calls; });
+    for (int i = 0; i < 8; ++i)
+      loader.stream((dir / ("order" + std::to_string(i) + ".wav")).string(), (sample::Deadline)i, [&calls](auto opened, const std::string&){ calls += opened ? 1 : 100; });
+    loader.drain();
+    for (bool all = false; !all; std::this_thread::yield()){ all = true; for (auto& x : s) all = all && x->ready(); }
+    run = false;
+    audio.join();
+    CHECK(calls == 12);
+  }
+  sample::SamplePool::shared().collect();
+}
+} // namespace
+
+int main(){
+  const fs::path dir = fs::temp_directory_path() / ("mydaw_sample_tests_" + std::to_string(::getpid()));
+  fs::create_directories(dir);
+  aiff_matches_wav(dir);
+  deadline_order(dir);
+  callbacks(dir);
+  stale_callbacks(dir);
+  stress(dir);
+  fs::remove_all(dir);
+  if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+  return failures ? 1 : 0;
+}